@@ -0,0 +1,145 @@
+#include "tcp_connection.hh"
+
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+// simulated path: a drop-tail bottleneck of `link_rate` bytes per ms with `queue_limit` bytes of buffer,
+// `delay` ms of propagation delay in each direction, and random loss in both directions
+constexpr double link_rate = 1500;
+constexpr double queue_limit = 16 * 1500;
+constexpr uint64_t delay = 10;
+constexpr uint64_t duration = 30 * 1000;
+
+//! One direction of the simulated path
+class Link {
+  private:
+    const bool _bottleneck;
+    const double _loss;
+    mt19937 &_rand;
+    // segments on the link, with their arrival time; ordered by arrival
+    deque<pair<double, TCPSegment>> _segments{};
+    // time at which the bottleneck finishes sending the queued segments
+    double _next_free{0};
+
+  public:
+    size_t dropped{0};
+
+    Link(const bool bottleneck, const double loss, mt19937 &rand) : _bottleneck(bottleneck), _loss(loss), _rand(rand) {}
+
+    void send(TCPSegment &&seg, const double now) {
+        if (uniform_real_distribution<double>{0, 1}(_rand) < _loss) {
+            dropped++;
+            return;
+        }
+        double departure = now;
+        if (_bottleneck) {
+            if ((_next_free - now) * link_rate > queue_limit) {
+                dropped++;
+                return;
+            }
+            _next_free = max(now, _next_free) + (seg.payload().size() + 40) / link_rate;
+            departure = _next_free;
+        }
+        _segments.emplace_back(departure + delay, move(seg));
+    }
+
+    void deliver(TCPConnection &receiver, const double now) {
+        while (not _segments.empty() and _segments.front().first <= now) {
+            receiver.segment_received(_segments.front().second);
+            _segments.pop_front();
+        }
+    }
+};
+
+void move_segments(TCPConnection &sender, Link &link, const double now) {
+    while (not sender.segments_out().empty()) {
+        link.send(move(sender.segments_out().front()), now);
+        sender.segments_out().pop();
+    }
+}
+
+//! Run a bulk transfer over the simulated path and print the goodput
+void simulate(const TCPConfig::Congestion congestion,
+              const string &name,
+              const double loss,
+              const bool fast_retransmit,
+              const bool sack,
+              const bool pacing = false) {
+    TCPConfig config;
+    config.congestion = congestion;
+    config.fast_retransmit = fast_retransmit;
+    config.sack = sack;
+    config.pacing = pacing;
+    config.rt_timeout = 100;
+    config.adaptive_rto = true;
+    config.rto_min = 20;
+    TCPConnection x{config}, y{config};
+
+    mt19937 rand{12345};
+    Link forward{true, loss, rand}, backward{false, loss, rand};
+
+    const string chunk(64 * 1024, 'x');
+    size_t bytes_received = 0;
+
+    auto exchange = [&](const uint64_t now) {
+        move_segments(x, forward, now);
+        forward.deliver(y, now);
+        move_segments(y, backward, now);
+        backward.deliver(x, now);
+
+        bytes_received += y.inbound_stream().buffer_size();
+        y.inbound_stream().pop_output(y.inbound_stream().buffer_size());
+
+        x.tick(1);
+        y.tick(1);
+    };
+
+    x.connect();
+    for (uint64_t now = 0; now < duration and x.active(); ++now) {
+        x.write(chunk.substr(0, x.remaining_outbound_capacity()));
+        exchange(now);
+    }
+    const size_t goodput_bytes = bytes_received;
+
+    // close both directions so the connections shut down cleanly
+    x.end_input_stream();
+    y.end_input_stream();
+    for (uint64_t now = duration; now < 10 * duration and (x.active() or y.active()); ++now) {
+        exchange(now);
+    }
+
+    const double goodput = goodput_bytes * 8.0 / duration / 1000.0;
+    cout << fixed << setprecision(2) << setw(8) << name << setw(6) << (fast_retransmit ? "yes" : "no") << setw(6)
+         << (sack ? "yes" : "no") << setw(8) << (pacing ? "yes" : "no") << setw(10)
+         << loss * 100 << "%" << setw(14) << goodput
+         << " Mbit/s" << setw(10) << forward.dropped + backward.dropped << " drops\n";
+}
+
+int main() {
+    try {
+        cout << "Bulk transfer over a " << link_rate * 8 / 1000 << " Mbit/s bottleneck with " << 2 * delay
+             << " ms RTT\n";
+        cout << "algorithm  fast retx  sack  pacing    loss       goodput        dropped\n";
+        for (const double loss : {0.0, 0.001, 0.01, 0.05}) {
+            for (const auto &[fast_retransmit, sack] : {pair{false, false}, pair{true, false}, pair{true, true}}) {
+                simulate(TCPConfig::Congestion::None, "none", loss, fast_retransmit, sack);
+                simulate(TCPConfig::Congestion::Reno, "reno", loss, fast_retransmit, sack);
+                simulate(TCPConfig::Congestion::Cubic, "cubic", loss, fast_retransmit, sack);
+            }
+            simulate(TCPConfig::Congestion::Reno, "reno", loss, true, true, true);
+            simulate(TCPConfig::Congestion::Cubic, "cubic", loss, true, true, true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
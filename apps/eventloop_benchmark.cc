@@ -0,0 +1,61 @@
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <sys/socket.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t n_wakeups = 20000;
+
+//! Wait on `n_fds` sockets, of which one at a time is ready, and return the time spent per wakeup
+double time_per_wakeup(const EventLoop::Backend backend, const size_t n_fds) {
+    EventLoop loop{backend};
+    vector<pair<FileDescriptor, FileDescriptor>> pairs;
+    pairs.reserve(n_fds);
+    for (size_t i = 0; i < n_fds; ++i) {
+        int fds[2];
+        SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, static_cast<int *>(fds)));
+        pairs.emplace_back(FileDescriptor(fds[0]), FileDescriptor(fds[1]));
+        loop.add_rule(pairs.back().first, Direction::In, [&pairs, i] { pairs[i].first.read(1); });
+    }
+
+    mt19937 rand{12345};
+    uniform_int_distribution<size_t> which{0, n_fds - 1};
+    const auto first_time = high_resolution_clock::now();
+    for (size_t i = 0; i < n_wakeups; ++i) {
+        pairs[which(rand)].second.write("x");
+        if (loop.wait_next_event(-1) != EventLoop::Result::Success) {
+            throw runtime_error("no event");
+        }
+    }
+    const auto final_time = high_resolution_clock::now();
+
+    return double(duration_cast<nanoseconds>(final_time - first_time).count()) / n_wakeups;
+}
+
+int main() {
+    try {
+        cout << "Time per wakeup with one ready fd\n";
+        cout << "      fds        poll       epoll\n";
+        for (const size_t n_fds : {10, 100, 1000, 8000}) {
+            cout << setw(9) << n_fds << fixed << setprecision(0) << setw(9)
+                 << time_per_wakeup(EventLoop::Backend::Poll, n_fds) << " ns" << setw(9)
+                 << time_per_wakeup(EventLoop::Backend::Epoll, n_fds) << " ns\n";
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,92 @@
+#include "address.hh"
+#include "datagram_ring.hh"
+#include "engine_pair.hh"
+#include "socket.hh"
+#include "tcp_config.hh"
+#include "tcp_engine.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr uint16_t server_port = 80;
+constexpr size_t n_connections = 16;
+constexpr size_t bytes_per_connection = 4 << 20;
+constexpr uint64_t transfer_timeout_ms = 600000;
+
+//! Transfer `n_connections` streams between two engines over loopback UDP, and print the system calls per GB
+void transfer(const bool io_uring) {
+    TCPConfig cfg{};
+    cfg.rt_timeout = 20;
+    const string data(bytes_per_connection, 'x');
+
+    size_t received = 0;
+    map<uint16_t, size_t> sent;
+    EnginePair engines(
+        [&](const FourTuple &, TCPConnection &connection) {
+            ByteStream &inbound = connection.inbound_stream();
+            received += inbound.read(inbound.buffer_size()).size();
+            if (inbound.eof()) {
+                connection.end_input_stream();
+            }
+        },
+        [&](const FourTuple &tuple, TCPConnection &connection) {
+            size_t &n = sent[tuple.local_port];
+            if (n < data.size()) {
+                n += connection.write(data.substr(n, cfg.send_capacity));
+                if (n == data.size()) {
+                    connection.end_input_stream();
+                }
+            }
+        },
+        io_uring);
+    engines.server.listen(cfg, server_port);
+
+    const uint64_t first_calls = system_call_count();
+    const auto first_time = high_resolution_clock::now();
+    const uint32_t loopback = Address("127.0.0.1").ipv4_numeric();
+    for (size_t i = 0; i < n_connections; ++i) {
+        engines.client.connect(cfg, {loopback, uint16_t(10000 + i), loopback, server_port});
+    }
+    if (not engines.run_until_closed(transfer_timeout_ms, server_port)) {
+        throw runtime_error("connections did not finish");
+    }
+    const auto final_time = high_resolution_clock::now();
+    const uint64_t calls = system_call_count() - first_calls;
+
+    if (received != n_connections * bytes_per_connection) {
+        throw runtime_error("received " + to_string(received) + " bytes");
+    }
+    const double gigabytes = double(received) / (1 << 30);
+    const double seconds = double(duration_cast<microseconds>(final_time - first_time).count()) / 1000000;
+    cout << setw(9) << (io_uring ? "io_uring" : "direct") << fixed << setprecision(0) << setw(14)
+         << double(calls) / gigabytes << setw(10) << setprecision(2) << 8 * gigabytes / seconds << " Gbit/s\n";
+}
+
+int main() {
+    try {
+        cout << "System calls to carry " << n_connections << " streams of " << (bytes_per_connection >> 20)
+             << " MiB over loopback UDP\n";
+        cout << "     path   calls per GB    throughput\n";
+        transfer(false);
+        UDPSocket probe;
+        if (DatagramRing::make(probe, true)) {
+            transfer(true);
+        } else {
+            cout << " io_uring  (not available: the kernel refused to set up an io_uring)\n";
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
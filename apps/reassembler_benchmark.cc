@@ -0,0 +1,67 @@
+#include "stream_reassembler.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t segment_size = 100;
+
+//! Push `n_segments` segments into a reassembler in the given order and return the time spent per segment
+double time_per_segment(const size_t n_segments, const bool shuffled, const StreamReassembler::Storage storage) {
+    string data(n_segments * segment_size, 'x');
+    for (auto &ch : data) {
+        ch = rand();
+    }
+
+    // every segment but the first arrives out of order, so all of them are held by the reassembler
+    vector<size_t> order(n_segments - 1);
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = n_segments - 1 - i;
+    }
+    if (shuffled) {
+        shuffle(order.begin(), order.end(), default_random_engine{});
+    }
+    order.push_back(0);
+
+    StreamReassembler reassembler{data.size(), storage};
+
+    const auto first_time = high_resolution_clock::now();
+    for (const auto i : order) {
+        reassembler.push_substring(data.substr(i * segment_size, segment_size), i * segment_size, false);
+    }
+    const auto final_time = high_resolution_clock::now();
+
+    if (reassembler.stream_out().buffer_size() != data.size() or
+        reassembler.stream_out().read(data.size()) != data) {
+        throw runtime_error("reassembled bytes don't match");
+    }
+
+    return double(duration_cast<nanoseconds>(final_time - first_time).count()) / n_segments;
+}
+
+int main() {
+    try {
+        cout << fixed << setprecision(1);
+        for (const auto storage : {StreamReassembler::Storage::Segments, StreamReassembler::Storage::Bitmap}) {
+            cout << (storage == StreamReassembler::Storage::Segments ? "Segment storage\n" : "Bitmap storage\n");
+            cout << "segments     reversed (ns/seg)     shuffled (ns/seg)\n";
+            for (size_t n_segments = 1024; n_segments <= 65536; n_segments *= 4) {
+                cout << setw(8) << n_segments << setw(22) << time_per_segment(n_segments, false, storage)
+                     << setw(22) << time_per_segment(n_segments, true, storage) << "\n";
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,5 +1,6 @@
 #include "tcp_connection.hh"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdlib>
 #include <iomanip>
@@ -17,19 +18,16 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
         x.segments_out().pop();
     }
     if (reorder) {
-        for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
-            y.segment_received(move(*it));
-        }
-    } else {
-        for (auto it = segments.begin(); it != segments.end(); ++it) {
-            y.segment_received(move(*it));
-        }
+        reverse(segments.begin(), segments.end());
     }
+    y.segments_received(segments);
     segments.clear();
 }
 
-void main_loop(const bool reorder) {
+void main_loop(const bool reorder, const size_t super_segment_size = 0, const size_t ack_delay = 0) {
     TCPConfig config;
+    config.super_segment_size = super_segment_size;
+    config.ack_delay = ack_delay;
     TCPConnection x{config}, y{config};
 
     string string_to_send(len, 'x');
@@ -96,7 +94,12 @@ void main_loop(const bool reorder) {
 
     cout << fixed << setprecision(2);
     cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+         << " Gbit/s" << (super_segment_size ? " (super-segments of " + to_string(super_segment_size) + " bytes)" : "")
+         << (ack_delay ? " (delayed ACKs)" : "") << "\n";
+
+    const auto &acks = y.ack_counters();
+    cout << "    " << acks.segments_to_ack << " segments received, " << acks.pure_acks_sent << " ACKs sent, "
+         << acks.coalesced << " coalesced, " << acks.piggybacked << " piggybacked\n";
 
     while (x.active() or y.active()) {
         loop();
@@ -107,6 +110,8 @@ int main() {
     try {
         main_loop(false);
         main_loop(true);
+        main_loop(false, 16 * TCPConfig::MAX_PAYLOAD_SIZE);
+        main_loop(false, 0, 200);
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
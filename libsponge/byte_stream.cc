@@ -1,5 +1,9 @@
 #include "byte_stream.hh"
 
+#include "file_descriptor.hh"
+
+#include <memory>
+
 // Dummy implementation of a flow-controlled in-memory byte stream.
 
 // For Lab 0, please replace with a real implementation that passes the
@@ -12,10 +16,14 @@
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t capacity):
+ByteStream::ByteStream(const size_t capacity, const bool chunked):
     //DUMMY_CODE(capacity); 
     maxCapacity (capacity),
-    bytes({}),
+    isChunked(chunked),
+    bytes(isChunked ? 0 : capacity, '\0'),
+    head(0),
+    bufferedBytes(0),
+    chunks(),
     readBytes(0),
     writtenBytes(0),
     inputEnd(false) {}
@@ -24,9 +32,66 @@ ByteStream::ByteStream(const size_t capacity):
 
 size_t ByteStream::write(const string &data) {
     //DUMMY_CODE(data);
+    return write_bytes(data);
+}
+
+size_t ByteStream::write_bytes(const string_view data) {
+    if(isChunked){
+        return write(Buffer(string(data.substr(0, remaining_capacity()))));
+    }
+    return writeBytes(data);
+}
+
+size_t ByteStream::write(const Buffer &data) {
+    if(!isChunked){
+        return writeBytes(data.str());
+    }
+    const size_t dataSize = min(remaining_capacity(), data.size());
+    if(dataSize == 0) return 0;
+    // only part of the Buffer may fit
+    Buffer chunk = data;
+    chunk.remove_suffix(data.size() - dataSize);
+    chunks.append(chunk);
+    bufferedBytes += dataSize;
+    writtenBytes += dataSize;
+    return dataSize;
+}
+
+size_t ByteStream::write_from(FileDescriptor &fd, const size_t limit) {
+    const size_t dataSize = min(remaining_capacity(), limit);
+    if(isChunked){
+        // read straight into the chunk's storage, which is left uninitialized rather than zero-filled
+        unique_ptr<char[]> data(new char[dataSize]);
+        const size_t readSize = fd.read({{data.get(), dataSize}});
+        Buffer chunk(move(data), dataSize);
+        chunk.remove_suffix(dataSize - readSize);
+        return write(chunk);
+    }
+    vector<iovec> freeSpace;
+    if(dataSize > 0){
+        // the free space starts right after the last buffered byte and may wrap around
+        const size_t tail = (head + bufferedBytes) % maxCapacity;
+        const size_t firstPart = min(dataSize, maxCapacity - tail);
+        freeSpace.push_back({bytes.data() + tail, firstPart});
+        if(dataSize > firstPart){
+            freeSpace.push_back({bytes.data(), dataSize - firstPart});
+        }
+    }
+    const size_t readSize = fd.read(freeSpace);
+    bufferedBytes += readSize;
+    writtenBytes += readSize;
+    return readSize;
+}
+
+size_t ByteStream::writeBytes(const string_view data) {
     const size_t dataSize = min(remaining_capacity(), data.size());
-    // add new string to the tail of old string
-    bytes = bytes + data.substr(0, dataSize);
+    if(dataSize == 0) return 0;
+    // the free space starts right after the last buffered byte and may wrap around
+    const size_t tail = (head + bufferedBytes) % maxCapacity;
+    const size_t firstPart = min(dataSize, maxCapacity - tail);
+    data.copy(bytes.data() + tail, firstPart);
+    data.copy(bytes.data(), dataSize - firstPart, firstPart);
+    bufferedBytes += dataSize;
     writtenBytes += dataSize;
     return dataSize;
 }
@@ -35,14 +100,34 @@ size_t ByteStream::write(const string &data) {
 string ByteStream::peek_output(const size_t len) const {
     //DUMMY_CODE(len);
     const size_t dataSize = min(buffer_size(), len);
-    return bytes.substr(0, dataSize);
+    string output;
+    output.reserve(dataSize);
+    if(isChunked){
+        for(const Buffer &chunk : chunks.buffers()){
+            if(output.size() == dataSize) break;
+            output.append(chunk.str().substr(0, dataSize - output.size()));
+        }
+        return output;
+    }
+    // the buffered bytes may wrap around the end of the circular buffer
+    const size_t firstPart = min(dataSize, maxCapacity - head);
+    output.append(bytes, head, firstPart);
+    output.append(bytes, 0, dataSize - firstPart);
+    return output;
 }
 
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) { 
     //DUMMY_CODE(len);
     const size_t dataSize = min(buffer_size(), len);
-    bytes = bytes.erase(0, dataSize);
+    if(dataSize == 0) return;
+    if(isChunked){
+        chunks.remove_prefix(dataSize);
+    }
+    else{
+        head = (head + dataSize) % maxCapacity;
+    }
+    bufferedBytes -= dataSize;
     readBytes += dataSize;
 }
 
@@ -58,6 +143,50 @@ std::string ByteStream::read(const size_t len) {
     return output;
 }
 
+BufferList ByteStream::peek_buffers(const size_t len) const {
+    const size_t dataSize = min(buffer_size(), len);
+    if(!isChunked){
+        return BufferList(peek_output(dataSize));
+    }
+    BufferList output;
+    size_t remaining = dataSize;
+    for(const Buffer &chunk : chunks.buffers()){
+        if(remaining == 0) break;
+        // the last chunk may be only partially peeked
+        Buffer piece = chunk;
+        piece.remove_suffix(chunk.size() - min(chunk.size(), remaining));
+        remaining -= piece.size();
+        output.append(piece);
+    }
+    return output;
+}
+
+BufferViewList ByteStream::peek_views(const size_t len) const {
+    const size_t dataSize = min(buffer_size(), len);
+    BufferViewList output;
+    size_t remaining = dataSize;
+    if(isChunked){
+        for(const Buffer &chunk : chunks.buffers()){
+            if(remaining == 0) break;
+            const string_view view = chunk.str().substr(0, remaining);
+            output.append(view);
+            remaining -= view.size();
+        }
+        return output;
+    }
+    // the buffered bytes may wrap around the end of the circular buffer
+    const size_t firstPart = min(dataSize, maxCapacity - head);
+    output.append(string_view(bytes).substr(head, firstPart));
+    output.append(string_view(bytes).substr(0, dataSize - firstPart));
+    return output;
+}
+
+BufferList ByteStream::read_buffers(const size_t len) {
+    BufferList output = peek_buffers(len);
+    pop_output(output.size());
+    return output;
+}
+
 void ByteStream::end_input() {
     inputEnd = true;
 }
@@ -67,7 +196,7 @@ bool ByteStream::input_ended() const {
 }
 
 size_t ByteStream::buffer_size() const { 
-    return bytes.size(); 
+    return bufferedBytes; 
 }
 
 bool ByteStream::buffer_empty() const { 
@@ -1,7 +1,12 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+
 #include <string>
+#include <string_view>
+
+class FileDescriptor;
 
 //! \brief An in-order byte stream.
 
@@ -13,7 +18,11 @@ class ByteStream {
     // Your code here -- add private members as necessary.
 
     const size_t maxCapacity; // max capacity of the byteStream
-    std::string bytes; // bytes are stored in it
+    const bool isChunked; // keep written Buffers by reference instead of copying them into bytes
+    std::string bytes; // circular buffer holding the stream, allocated once with maxCapacity bytes
+    size_t head; // index in bytes of the first unread byte
+    size_t bufferedBytes; // number of bytes in the buffer that have not been read
+    BufferList chunks; // unread Buffers in chunked mode (bytes stays empty)
     size_t readBytes; // number of bytes read from this stream
     size_t writtenBytes; // number of bytes written to this stream
     bool inputEnd; // whether writer end the input?
@@ -25,9 +34,15 @@ class ByteStream {
 
     bool _error{};  //!< Flag indicating that the stream suffered an error.
 
+    // copy up to remaining_capacity() bytes into the circular buffer
+    // return the bytes of data written
+    size_t writeBytes(const std::string_view data);
+
   public:
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t capacity);
+    //! \param chunked if `true`, written Buffers are stored by reference instead of being
+    //!                copied into a contiguous buffer
+    ByteStream(const size_t capacity, const bool chunked = false);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -37,6 +52,20 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Write bytes from a string_view into the stream, copying them.
+    //! \returns the number of bytes accepted into the stream
+    size_t write_bytes(const std::string_view data);
+
+    //! Write a Buffer into the stream. In chunked mode the accepted bytes are
+    //! kept by reference, otherwise they are copied.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const Buffer &data);
+
+    //! Read up to `limit` bytes from `fd` directly into the stream's free space,
+    //! without an intermediate string.
+    //! \returns the number of bytes read from `fd` (and written into the stream)
+    size_t write_from(FileDescriptor &fd, const size_t limit);
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
@@ -61,6 +90,19 @@ class ByteStream {
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Peek at next "len" bytes of the stream without copying them where possible
+    //! \returns the stored Buffers (shared, not copied) in chunked mode, otherwise a single copied Buffer
+    BufferList peek_buffers(const size_t len) const;
+
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \returns views into the stream's storage (at most two in the circular buffer), valid
+    //! until the stream is next written to or popped
+    BufferViewList peek_views(const size_t len) const;
+
+    //! Read (i.e., peek and then pop) the next "len" bytes of the stream as Buffers
+    //! \returns a BufferList, see peek_buffers()
+    BufferList read_buffers(const size_t len);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
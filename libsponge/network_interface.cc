@@ -3,6 +3,7 @@
 #include "arp_message.hh"
 #include "ethernet_frame.hh"
 
+#include <algorithm>
 #include <iostream>
 #include <set>
 
@@ -13,6 +14,12 @@
 
 using namespace std;
 
+//! ms after which an ARP cache entry is forgotten
+static constexpr size_t ARP_ENTRY_TTL = 30 * 1000;
+
+//! ms after which an ARP request for the same address may be sent again
+static constexpr size_t ARP_REQUEST_TTL = 5 * 1000;
+
 //! \param[in] ethernet_address Ethernet (what ARP calls "hardware") address of the interface
 //! \param[in] ip_address IP (what ARP calls "protocol") address of the interface
 NetworkInterface::NetworkInterface(const EthernetAddress &ethernet_address, const Address &ip_address)
@@ -77,8 +84,25 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void NetworkInterface::tick(const size_t ms_since_last_tick) { 
     _current_time += ms_since_last_tick;
-    _clean_arp_cache(30*1000);
-    _clean_request_cache(5*1000);
+    _clean_arp_cache(ARP_ENTRY_TTL);
+    _clean_request_cache(ARP_REQUEST_TTL);
+}
+
+optional<size_t> NetworkInterface::ms_until_deadline() const {
+    optional<size_t> deadline{};
+    // an entry is removed once it is more than its ttl old
+    const auto earliest = [&](const size_t time, const size_t ttl){
+        const size_t expiry = time + ttl + 1;
+        const size_t ms = expiry > _current_time ? expiry - _current_time : 0;
+        deadline = min(deadline.value_or(ms), ms);
+    };
+    for(auto const &item : _arp_cache){
+        earliest(item.second.second, ARP_ENTRY_TTL);
+    }
+    for(auto const &item : _request_cache){
+        earliest(item.second, ARP_REQUEST_TTL);
+    }
+    return deadline;
 }
 
 /*------------------------- private methods -------------------------------------*/
@@ -99,6 +99,10 @@ class NetworkInterface {
 
     //! \brief Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
+
+    //! \brief ms until tick() next expires an ARP cache entry or an ARP request
+    //! \returns an empty value if both caches are empty
+    std::optional<size_t> ms_until_deadline() const;
 };
 
 #endif  // SPONGE_LIBSPONGE_NETWORK_INTERFACE_HH
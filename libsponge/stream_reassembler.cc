@@ -12,13 +12,17 @@
 
 using namespace std;
 
-StreamReassembler::StreamReassembler(const size_t capacity) : 
-    _output(capacity), 
+StreamReassembler::StreamReassembler(const size_t capacity, const Storage storage) : 
+    _storage(storage),
+    // with the bitmap, contiguous bytes are copied out of the window anyway, so keep them contiguous
+    _output(capacity, storage == Storage::Segments), 
     _capacity(capacity),
     unassembledBytes(0),
     remarkEOF(false),
     endIndex(0),
-    subStrings() {}
+    subStrings(),
+    window(storage == Storage::Bitmap ? capacity : 0, '\0'),
+    present(storage == Storage::Bitmap ? (capacity + 63) / 64 : 0, 0) {}
 
 //! \details This function accepts a substring (aka a segment) of bytes,
 //! possibly out-of-order, from the logical stream, and assembles any newly
@@ -29,15 +33,43 @@ void StreamReassembler::push_substring(const string &data, const size_t index, c
         remarkEOF = true;
         endIndex = index + data.size();
     }
-    Segment next{data, index};
-    mergeSegment(next);
-
-
-    writeSegments();
+    if(_storage == Storage::Bitmap){
+        mergeIntoWindow(data, index);
+        writeWindow();
+    }
+    else{
+        // segments are kept as Buffers, so copy only the part of data that fits in the window
+        const size_t headIndex = _output.bytes_written();
+        const size_t start = min(max(index, headIndex), index + data.size());
+        const size_t end = max(start, min(index + data.size(), headIndex + _output.remaining_capacity()));
+        mergeSegment(Buffer(data.substr(start - index, end - start)), start);
+        writeSegments();
+    }
+    checkEOF();
+}
 
-    if(remarkEOF && _output.bytes_written() == endIndex){
-        _output.end_input();
+void StreamReassembler::push_substring(const Buffer &data, const size_t index, const bool eof) {
+    if(eof){
+        remarkEOF = true;
+        endIndex = index + data.size();
+    }
+    const size_t headIndex = _output.bytes_written();
+    if(unassembledBytes == 0 && index <= headIndex && index + data.size() > headIndex){
+        // next in order and nothing is waiting: drop the already written prefix
+        // and hand the rest to the stream directly
+        Buffer next = data;
+        next.remove_prefix(headIndex - index);
+        _output.write(next);
+    }
+    else if(_storage == Storage::Bitmap){
+        mergeIntoWindow(data.str(), index);
+        writeWindow();
     }
+    else{
+        mergeSegment(data, index);
+        writeSegments();
+    }
+    checkEOF();
 }
 
 size_t StreamReassembler::unassembled_bytes() const { 
@@ -45,59 +77,176 @@ size_t StreamReassembler::unassembled_bytes() const {
 }
 
 bool StreamReassembler::empty() const { 
-    return subStrings.empty(); 
+    return unassembledBytes == 0; 
 }
 
-void StreamReassembler::mergeSegment(const Segment & seg){
+vector<pair<uint64_t, uint64_t>> StreamReassembler::unassembled_ranges() const {
+    vector<pair<uint64_t, uint64_t>> ranges;
+    auto addRange = [&ranges](const uint64_t start, const uint64_t end){
+        if(!ranges.empty() && ranges.back().second == start){
+            ranges.back().second = end;
+        }
+        else{
+            ranges.emplace_back(start, end);
+        }
+    };
+
+    if(_storage == Storage::Segments){
+        for(const auto &[index, data] : subStrings){
+            addRange(index, index + data.size());
+        }
+        return ranges;
+    }
+
+    // walk the window from its head in runs of present or absent bits, until every stored byte is found
     const size_t headIndex = _output.bytes_written();
-    size_t start = max(seg.index, headIndex);
-    size_t end = min(seg.index + seg.data.size(), headIndex+_output.remaining_capacity());
-    if(start >= end) return;
+    const size_t windowSize = _output.remaining_capacity();
+    size_t found = 0;
+    for(size_t offset = 0; offset < windowSize && found < unassembledBytes;){
+        const size_t pos = (headIndex + offset) % _capacity;
+        const bool isPresent = (present[pos / 64] >> (pos % 64)) & 1;
+        const size_t run = min(bitRun(pos, isPresent), windowSize - offset);
+        if(isPresent){
+            addRange(headIndex + offset, headIndex + offset + run);
+            found += run;
+        }
+        offset += run;
+    }
+    return ranges;
+}
 
-    std::set<Segment> removedSegs;
+void StreamReassembler::mergeSegment(const Buffer &data, const size_t index){
+    const size_t headIndex = _output.bytes_written();
+    size_t start = max(index, headIndex);
+    size_t end = min(index + data.size(), headIndex+_output.remaining_capacity());
+    if(start >= end) return;
 
-    for(Segment oldSeg : subStrings){
-        const size_t oldStart =  oldSeg.index;
-        const size_t oldEnd = oldStart + oldSeg.data.size();
+    // the first segment starting after start, the one before it is the only one that can cover start
+    auto next = subStrings.upper_bound(start);
+    if(next != subStrings.begin()){
+        const auto prev = std::prev(next);
+        const size_t prevEnd = prev->first + prev->second.size();
+        // old segment fully cover the new segment
+        if(prevEnd >= end) return;
+        // data between [start, prevEnd] is overlap
+        if(prevEnd > start) start = prevEnd;
+    }
 
-        if(oldStart <= start){
-            // no overlap between the two segment
-            if(oldEnd <= start) continue;
-            // data between [start, oldEnd] is overlap
-            else if (oldEnd <= end) start = oldEnd;
-            // old segment fully cover the new segment
-            else return;
-        }
-        else if (oldStart < end){
-            // new segment fully cover the old segment
-            if(oldEnd <= end) removedSegs.insert(oldSeg);
-            // overlap between [oldStart, end]
-            else end = oldStart;
+    // segments starting inside [start, end)
+    while(next != subStrings.end() && next->first < end){
+        const size_t nextEnd = next->first + next->second.size();
+        // overlap between [next->first, end]
+        if(nextEnd > end){
+            end = next->first;
+            break;
         }
-        // no overlap between the two segment
-        else break;
+        // new segment fully cover the old segment
+        unassembledBytes -= next->second.size();
+        next = subStrings.erase(next);
     }
 
-    for(auto oldSeg : removedSegs){
-        subStrings.erase(oldSeg);
-        unassembledBytes -= oldSeg.data.size();
+    if(end > start){
+        // keep a view of [start, end) of data
+        Buffer piece = data;
+        piece.remove_prefix(start - index);
+        piece.remove_suffix(index + data.size() - end);
+        // a small piece of a large datagram is copied, so that memory held stays bounded by the capacity
+        if(piece.size() * MAX_STORAGE_RATIO < piece.storage_size()){
+            piece = Buffer(piece.copy());
+        }
+        subStrings.emplace_hint(next, start, std::move(piece));
+        unassembledBytes += (end - start);
     }
+}
 
-    if(end - start > 0){
-        const Segment newSeg{seg.data.substr(start - seg.index, end - start), start};
-        subStrings.insert(newSeg);
-        unassembledBytes += (end - start);
+void StreamReassembler::checkEOF(){
+    if(remarkEOF && _output.bytes_written() == endIndex){
+        _output.end_input();
     }
 }
 
 void StreamReassembler::writeSegments(){
     // write sub strings to output
     while(!subStrings.empty()){
-        auto next = subStrings.begin();        
-        if((*next).index == _output.bytes_written()){
-            unassembledBytes -= _output.write((*next).data);
+        auto next = subStrings.begin();
+        if(next->first == _output.bytes_written()){
+            // the stored Buffer is handed over to the stream without copying
+            unassembledBytes -= _output.write(next->second);
             subStrings.erase(next);
         }
         else break;
     }
 }
+
+void StreamReassembler::mergeIntoWindow(const string_view data, const size_t index){
+    const size_t headIndex = _output.bytes_written();
+    const size_t start = max(index, headIndex);
+    const size_t end = min(index + data.size(), headIndex+_output.remaining_capacity());
+    if(start >= end) return;
+
+    // the range may wrap around the end of the window
+    const size_t pos = start % _capacity;
+    const size_t firstPart = min(end - start, _capacity - pos);
+    data.copy(window.data() + pos, firstPart, start - index);
+    data.copy(window.data(), end - start - firstPart, start - index + firstPart);
+    unassembledBytes += markPresent(pos, firstPart, true);
+    unassembledBytes += markPresent(0, end - start - firstPart, true);
+}
+
+void StreamReassembler::writeWindow(){
+    if(unassembledBytes == 0) return;
+    const size_t pos = _output.bytes_written() % _capacity;
+    const size_t firstPart = bitRun(pos, true);
+    // the run reaches the end of the window and may continue at its beginning
+    const size_t secondPart = (pos + firstPart == _capacity) ? bitRun(0, true) : 0;
+    if(firstPart == 0) return;
+
+    _output.write_bytes(string_view(window).substr(pos, firstPart));
+    _output.write_bytes(string_view(window).substr(0, secondPart));
+    unassembledBytes -= markPresent(pos, firstPart, false);
+    unassembledBytes -= markPresent(0, secondPart, false);
+}
+
+size_t StreamReassembler::markPresent(size_t pos, size_t len, const bool isPresent){
+    size_t changed = 0;
+    // work on whole 64-bit words, masking the partial ones at both ends
+    while(len > 0){
+        const size_t bit = pos % 64;
+        const size_t n = min(len, 64 - bit);
+        const uint64_t mask = (n == 64 ? ~uint64_t(0) : ((uint64_t(1) << n) - 1)) << bit;
+        uint64_t &word = present[pos / 64];
+        if(isPresent){
+            changed += __builtin_popcountll(mask & ~word);
+            word |= mask;
+        }
+        else{
+            changed += __builtin_popcountll(mask & word);
+            word &= ~mask;
+        }
+        pos += n;
+        len -= n;
+    }
+    return changed;
+}
+
+size_t StreamReassembler::bitRun(size_t pos, const bool isPresent) const{
+    const size_t start = pos;
+    size_t run = 0;
+    while(pos < _capacity){
+        const size_t bit = pos % 64;
+        const uint64_t word = isPresent ? present[pos / 64] : ~present[pos / 64];
+        // the lowest set bit of other is the first byte that differs from pos on
+        const uint64_t other = ~(word >> bit);
+        if(other == 0){
+            run += 64;
+            pos += 64;
+            continue;
+        }
+        const size_t n = __builtin_ctzll(other);
+        run += n;
+        if(n < 64 - bit) break;
+        pos += n;
+    }
+    // bits past _capacity are never set, so only a run of absent bits can pass the end of the window
+    return min(run, _capacity - start);
+}
@@ -4,48 +4,67 @@
 #include "byte_stream.hh"
 
 #include <cstdint>
+#include <map>
 #include <string>
-#include <set>
+#include <string_view>
 #include <utility>
-
-// subString stored in queue by its index,
-// smallest indexed string is at top
+#include <vector>
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
 class StreamReassembler {
-  struct Segment{
-    const std::string data;
-    const size_t index;
-    Segment(std::string s, size_t x) : data(s), index(x) {}
-    bool operator<(const struct Segment that) const {
-        return this->index < that.index;
-    }
-  };
+  public:
+    //! \brief How bytes that are not yet contiguous are stored
+    enum class Storage {
+        Segments,  //!< an ordered map of substrings, only as large as the bytes held
+        Bitmap     //!< a capacity-sized ring buffer and a bitmap of the bytes present (no allocation per push)
+    };
 
   private:
     // Your code here -- add private members as necessary.
 
+    Storage _storage;    //!< How unassembled bytes are stored
     ByteStream _output;  //!< The reassembled in-order byte stream
     size_t _capacity;    //!< The maximum number of bytes
     size_t unassembledBytes;
     bool remarkEOF;
     size_t endIndex; // the index of EOF
 
-    // store all unassembled sub strings
-    std::set<Segment> subStrings;  
+    // store all unassembled sub strings, keyed by the index of their first byte
+    // stored sub strings never overlap each other; they are trimmed views of the
+    // pushed Buffers, so holding out-of-order data does not copy it
+    // (unless the view is less than 1/MAX_STORAGE_RATIO of the Buffer's storage)
+    std::map<size_t, Buffer> subStrings;
+    static constexpr size_t MAX_STORAGE_RATIO = 4;
 
-    // add a new segment to subStrings
-    // return the bytes of data added
-    void mergeSegment(const Segment & seg);
+    // Storage::Bitmap: the byte at stream index i is kept at window[i % _capacity],
+    // and bit i % _capacity of present tells whether it has been received
+    std::string window;
+    std::vector<uint64_t> present;
+
+    // add the part of data that is not stored yet to subStrings
+    // only the stored sub strings overlapping data are visited
+    void mergeSegment(const Buffer &data, const size_t index);
     // write segments to byte stream
     void writeSegments();
 
+    // copy data into window and mark its bytes present
+    void mergeIntoWindow(const std::string_view data, const size_t index);
+    // write the present bytes at the head of window to byte stream
+    void writeWindow();
+    // set (or clear) the bits of [pos, pos + len) in present
+    // return the number of bits that changed
+    size_t markPresent(size_t pos, size_t len, const bool isPresent);
+    // number of consecutive bits equal to isPresent starting at pos (not wrapping around)
+    size_t bitRun(size_t pos, const bool isPresent) const;
+    // close the output if all bytes before EOF have been written
+    void checkEOF();
+
   public:
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
     //! \note This capacity limits both the bytes that have been reassembled,
     //! and those that have not yet been reassembled.
-    StreamReassembler(const size_t capacity);
+    StreamReassembler(const size_t capacity, const Storage storage = Storage::Segments);
 
     //! \brief Receive a substring and write any newly contiguous bytes into the stream.
     //!
@@ -57,6 +76,12 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receive a substring held in a Buffer.
+    //!
+    //! With Storage::Segments the bytes are never copied: out-of-order data is held as
+    //! trimmed views of `data` and handed to the output stream by reference once contiguous.
+    void push_substring(const Buffer &data, const uint64_t index, const bool eof);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -72,6 +97,10 @@ class StreamReassembler {
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
+
+    //! \brief The ranges of bytes stored but not yet reassembled
+    //! \returns [first index, last index + 1) of each range, in order; adjacent ranges are merged
+    std::vector<std::pair<uint64_t, uint64_t>> unassembled_ranges() const;
 };
 
 #endif  // SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
@@ -1,6 +1,7 @@
 #include "tcp_connection.hh"
 
 #include <iostream>
+#include <limits>
 
 // For Lab 4, please replace with a real implementation that passes the
 // automated checks run by `make check`.
@@ -8,7 +9,7 @@
 using namespace std;
 
 size_t TCPConnection::remaining_outbound_capacity() const { 
-    return _sender.stream_in().buffer_size(); 
+    return _sender.stream_in().remaining_capacity(); 
 }
 
 size_t TCPConnection::bytes_in_flight() const { 
@@ -24,6 +25,26 @@ size_t TCPConnection::time_since_last_segment_received() const {
 }
 
 void TCPConnection::segment_received(const TCPSegment &seg) { 
+    _process_segment(seg);
+    _send_all_segments();
+}
+
+void TCPConnection::segments_received(const vector<TCPSegment> &segments) {
+    for(const TCPSegment &seg : segments){
+        if(!active()){
+            break;
+        }
+        const optional<WrappingInt32> ackno = _receiver.ackno();
+        _process_segment(seg);
+        // a duplicate ack for out-of-order data goes out on its own, the peer counts them
+        if(seg.payload().size() > 0 && _receiver.ackno() == ackno){
+            _send_all_segments();
+        }
+    }
+    _send_all_segments();
+}
+
+void TCPConnection::_process_segment(const TCPSegment &seg) {
     _time_since_last_receive = 0;
     
     const TCPHeader &header = seg.header();
@@ -33,11 +54,37 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
     }
     // deal with a normal segment
     else{
-        _receiver.segment_received(seg);
+        // an old duplicate rejected by PAWS is only acknowledged
+        const size_t unassembled = _receiver.unassembled_bytes();
+        if(!_receiver.segment_received(seg)){
+            if(seg.length_in_sequence_space() > 0){
+                _ack_segment(seg, true);
+            }
+            return;
+        }
+
+        // SACK and window scaling are used if both SYNs offered them
+        if(header.syn){
+            _sack_permitted = _cfg.sack && header.sack_permitted;
+            _window_scaling = _cfg.window_scaling && header.window_scale.has_value();
+            if(_window_scaling){
+                _snd_window_scale = min(header.window_scale.value(), TCPHeader::MAX_WINDOW_SCALE);
+                _rcv_window_scale = _window_scale_for(_cfg.recv_capacity);
+            }
+            _timestamps = _cfg.timestamps && header.timestamps.has_value();
+        }
 
         // update ackno and window size of sender
+        if(_sack_permitted && !header.sack.empty()){
+            _sender.sack_received(header.sack);
+        }
+        if(_timestamps && header.timestamps.has_value()){
+            _sender.timestamp_echo_received(header.timestamps->second);
+        }
         if(header.ack){
-            _sender.ack_received(header.ackno, header.win);
+            // the window of a SYN segment is never scaled
+            const size_t window = static_cast<size_t>(header.win) << (header.syn ? 0 : _snd_window_scale);
+            _sender.ack_received(header.ackno, window, seg.length_in_sequence_space() == 0);
         }
         // passive open the sender
         if(header.syn){
@@ -47,11 +94,11 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         if(header.fin && (!_sender.stream_in().eof())){
             _linger_after_streams_finish = false;
         }
-        // if no seg in sender, create an empty one for ack
-        if(seg.length_in_sequence_space() > 0 && _sender.segments_out().empty()){
-            _sender.send_empty_segment();
+        // ack out-of-order data and filled holes at once (RFC 5681), delay the others
+        if(seg.length_in_sequence_space() > 0){
+            const bool in_order = unassembled == 0 && _receiver.unassembled_bytes() == 0;
+            _ack_segment(seg, !in_order || header.syn || header.fin);
         }
-        _send_all_segments();
     }
 }
 
@@ -66,11 +113,26 @@ size_t TCPConnection::write(const string &data) {
     return written;
 }
 
+size_t TCPConnection::write_from(FileDescriptor &source, const size_t limit) {
+    const size_t written = _sender.stream_in().write_from(source, limit);
+    _sender.fill_window();
+    _send_all_segments();
+    return written;
+}
+
 //! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
 void TCPConnection::tick(const size_t ms_since_last_tick) {
     _time_since_last_receive += ms_since_last_tick;
     _sender.tick(ms_since_last_tick); 
 
+    // the delayed ack timer expired
+    if(_ack_pending){
+        _ack_timer += ms_since_last_tick;
+        if(_ack_timer >= _cfg.ack_delay && _sender.segments_out().empty()){
+            _sender.send_empty_segment();
+        }
+    }
+
     // reset both pairs if retransmit many times
     if(_sender.consecutive_retransmissions() > TCPConfig::MAX_RETX_ATTEMPTS){
         _send_rst();
@@ -82,12 +144,41 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
 
 }
 
+optional<size_t> TCPConnection::ms_until_deadline() const {
+    if(!active()){
+        return {};
+    }
+    optional<size_t> deadline = _sender.ms_until_deadline();
+    const auto earliest = [&](const size_t ms){ deadline = min(deadline.value_or(ms), ms); };
+
+    if(_ack_pending){
+        earliest(_ack_timer < _cfg.ack_delay ? _cfg.ack_delay - _ack_timer : 0);
+    }
+    // lingering after both streams finished
+    if(_linger_after_streams_finish && _receiver.stream_out().eof() &&
+       _sender.stream_in().eof() && _sender.bytes_in_flight() == 0){
+        const size_t linger = 10 * _cfg.rt_timeout;
+        earliest(_time_since_last_receive < linger ? linger - _time_since_last_receive : 0);
+    }
+    return deadline;
+}
+
 void TCPConnection::end_input_stream() {
     _sender.stream_in().end_input(); 
     _sender.fill_window();
     _send_all_segments();
 }
 
+void TCPConnection::cork() {
+    _sender.set_corked(true);
+}
+
+void TCPConnection::uncork() {
+    _sender.set_corked(false);
+    _sender.fill_window();
+    _send_all_segments();
+}
+
 void TCPConnection::connect() {
     // sender create the FIN segment
     _sender.fill_window();
@@ -112,20 +203,89 @@ TCPConnection::~TCPConnection() {
 /* ------------------------------private methods---------------------------------------- */
 
 void TCPConnection::_send_all_segments(){
+    if(_sender.segments_out().empty()){
+        return;
+    }
+    // the receiver's fields are the same for every segment
+    const optional<WrappingInt32> ackno = _receiver.ackno();
+    const size_t window = _receiver.window_size();
+    const uint16_t win = min(window >> _rcv_window_scale, static_cast<size_t>(numeric_limits<uint16_t>::max()));
+    const uint16_t syn_win = min(window, static_cast<size_t>(numeric_limits<uint16_t>::max()));
+    const uint32_t timestamp_echo = _receiver.timestamp_echo().value_or(0);
+    vector<pair<WrappingInt32, WrappingInt32>> sack{};
+    if(_sack_permitted){
+        sack = _receiver.sack_blocks(_timestamps ? TCPHeader::MAX_SACK_BLOCKS_WITH_TIMESTAMPS
+                                                 : TCPHeader::MAX_SACK_BLOCKS);
+    }
+
     while(!_sender.segments_out().empty()){
-        TCPSegment seg = _sender.segments_out().front();
-        // update the receiver's responsible fields
-        seg.header().win = _receiver.window_size();
-        if(_receiver.ackno().has_value()){
-            seg.header().ack = true;
-            seg.header().ackno = _receiver.ackno().value();
-        }
-        // send the segment
-        _segments_out.push(seg);
+        // patch the receiver's fields in place and move the segment on
+        TCPSegment &seg = _sender.segments_out().front();
+        TCPHeader &header = seg.header();
+        header.win = header.syn ? syn_win : win;
+        if(ackno.has_value()){
+            header.ack = true;
+            header.ackno = ackno.value();
+        }
+        if(header.syn){
+            header.sack_permitted = _cfg.sack;
+            // a SYN/ACK only offers window scaling and timestamps if the peer's SYN did
+            const bool active_open = !ackno.has_value();
+            if(_cfg.window_scaling && (active_open || _window_scaling)){
+                header.window_scale = _window_scale_for(_cfg.recv_capacity);
+            }
+            if(_cfg.timestamps && (active_open || _timestamps)){
+                header.timestamps.emplace(_sender.timestamp(), timestamp_echo);
+            }
+        }
+        else if(_timestamps){
+            header.timestamps.emplace(_sender.timestamp(), timestamp_echo);
+        }
+        header.sack = sack;
+        // any segment carries the pending ack
+        const bool pure_ack = seg.length_in_sequence_space() == 0 && !header.rst;
+        if(header.ack && _ack_pending){
+            _ack_pending = false;
+            _ack_pending_bytes = 0;
+            _ack_timer = 0;
+            _ack_counters.piggybacked += pure_ack ? 0 : 1;
+        }
+        // an ack that advances the ackno replaces one that is still waiting to be sent,
+        // but duplicate acks are kept as they signal loss to the peer
+        TCPSegment *const last = _segments_out.empty() ? nullptr : &_segments_out.back();
+        if(pure_ack && last != nullptr && last->length_in_sequence_space() == 0 && !last->header().rst &&
+           last->header().ack && last->header().ackno != header.ackno){
+            *last = std::move(seg);
+            _ack_counters.coalesced += 1;
+        }
+        else{
+            _ack_counters.pure_acks_sent += pure_ack ? 1 : 0;
+            _segments_out.push(std::move(seg));
+        }
         _sender.segments_out().pop();
     }
 }
 
+void TCPConnection::_ack_segment(const TCPSegment &seg, const bool immediate){
+    _ack_counters.segments_to_ack += 1;
+    _ack_pending = true;
+    _ack_pending_bytes += seg.payload().size();
+    // ack at least every second full-sized segment (RFC 1122)
+    if(_cfg.ack_delay == 0 || immediate || _ack_pending_bytes >= 2 * _cfg.mss){
+        if(_sender.segments_out().empty()){
+            _sender.send_empty_segment();
+        }
+    }
+}
+
+uint8_t TCPConnection::_window_scale_for(const size_t capacity){
+    uint8_t shift = 0;
+    while(shift < TCPHeader::MAX_WINDOW_SCALE && (capacity >> shift) > numeric_limits<uint16_t>::max()){
+        shift++;
+    }
+    return shift;
+}
+
 void TCPConnection::_unclean_shutdown(){
     _sender.stream_in().set_error();
     _receiver.stream_out().set_error();
@@ -1,19 +1,57 @@
 #ifndef SPONGE_LIBSPONGE_TCP_FACTORED_HH
 #define SPONGE_LIBSPONGE_TCP_FACTORED_HH
 
+#include "file_descriptor.hh"
 #include "tcp_config.hh"
 #include "tcp_receiver.hh"
 #include "tcp_sender.hh"
 #include "tcp_state.hh"
 
+#include <cstdint>
+#include <optional>
+#include <vector>
+
 //! \brief A complete endpoint of a TCP connection
 class TCPConnection {
+  public:
+    //! Counts of the segments that needed an ACK and of the ACKs that were sent for them
+    struct AckCounters {
+        size_t segments_to_ack{0};  //!< received segments that occupy sequence space
+        size_t pure_acks_sent{0};   //!< ACK segments sent without data
+        size_t piggybacked{0};      //!< pending ACKs that a segment with data carried
+        size_t coalesced{0};        //!< ACKs merged into an earlier one still waiting in segments_out()
+    };
+
   private:
     TCPConfig _cfg;
-    TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+    TCPReceiver _receiver{_cfg.recv_capacity,
+                          _cfg.bitmap_reassembly ? StreamReassembler::Storage::Bitmap
+                                                 : StreamReassembler::Storage::Segments};
+    TCPSender _sender{_cfg};
     size_t _time_since_last_receive {0};
 
+    //! whether both ends offered SACK in their SYN
+    bool _sack_permitted{false};
+
+    //! whether both ends offered window scaling in their SYN
+    bool _window_scaling{false};
+    //! shift applied to the windows we advertise
+    uint8_t _rcv_window_scale{0};
+    //! shift applied to the windows the peer advertises
+    uint8_t _snd_window_scale{0};
+
+    //! whether both ends offered timestamps in their SYN
+    bool _timestamps{false};
+
+    //! whether a received segment has not been acknowledged yet
+    bool _ack_pending{false};
+    //! payload bytes received since the last ACK was sent
+    size_t _ack_pending_bytes{0};
+    //! milliseconds since the pending ACK was delayed
+    size_t _ack_timer{0};
+
+    AckCounters _ack_counters{};
+
     //! outbound queue of segments that the TCPConnection wants sent
     std::queue<TCPSegment> _segments_out{};
 
@@ -22,6 +60,16 @@ class TCPConnection {
     //! If there is an ackno in the receiver, the segments' acks will be set
     void _send_all_segments();
 
+    //! handle a received segment, leaving the segments it causes in the sender
+    void _process_segment(const TCPSegment &seg);
+
+    //! acknowledge a received segment that occupies sequence space, at once or delayed
+    //! \param[in] immediate whether the ACK must not be delayed (out-of-order data, SYN or FIN)
+    void _ack_segment(const TCPSegment &seg, const bool immediate);
+
+    //! smallest window shift that lets the advertised window cover `capacity`
+    static uint8_t _window_scale_for(const size_t capacity);
+
     //! shutdown the local connection immediately 
     void _unclean_shutdown();
 
@@ -50,11 +98,22 @@ class TCPConnection {
     //! \returns the number of bytes from `data` that were actually written.
     size_t write(const std::string &data);
 
+    //! \brief Read up to `limit` bytes from `source` straight into the outbound byte stream,
+    //! and send them over TCP if possible
+    //! \returns the number of bytes read from `source`
+    size_t write_from(FileDescriptor &source, const size_t limit);
+
     //! \returns the number of `bytes` that can be written right now.
     size_t remaining_outbound_capacity() const;
 
     //! \brief Shut down the outbound byte stream (still allows reading incoming data)
     void end_input_stream();
+
+    //! \brief Hold back written data until it fills a segment or uncork() is called
+    void cork();
+
+    //! \brief Stop holding back written data, and send what is held
+    void uncork();
     //!@}
 
     //! \name "Output" interface for the reader
@@ -73,6 +132,12 @@ class TCPConnection {
     size_t unassembled_bytes() const;
     //! \brief Number of milliseconds since the last segment was received
     size_t time_since_last_segment_received() const;
+    //! \brief the sender's pacing rate in bytes per second, if it paces
+    std::optional<uint64_t> pacing_rate() const { return _sender.pacing_rate(); }
+    //! \brief the sender's smoothed RTT in ms, once `adaptive_rto` has measured one
+    std::optional<double> smoothed_rtt() const { return _sender.smoothed_rtt(); }
+    //! \brief how many ACKs were sent, delayed, and coalesced
+    const AckCounters &ack_counters() const { return _ack_counters; }
     //!< \brief summarize the state of the sender, receiver, and the connection
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
     //!@}
@@ -83,15 +148,31 @@ class TCPConnection {
     //! Called when a new segment has been received from the network
     void segment_received(const TCPSegment &seg);
 
+    //! \brief Called with a burst of segments received from the network
+    //! \details Same as calling segment_received() for each, but the ACK, window and outbound
+    //! segments are computed once for the whole burst (duplicate ACKs are still sent one by one)
+    void segments_received(const std::vector<TCPSegment> &segments);
+
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
+    //! \brief ms until tick() has something to do: a retransmission, paced data, a delayed ACK,
+    //! or the end of lingering in TIME_WAIT
+    //! \returns an empty value if no timer is running, so the connection needs no tick until
+    //! a segment arrives or the application writes
+    std::optional<size_t> ms_until_deadline() const;
+
     //! \brief TCPSegments that the TCPConnection has enqueued for transmission.
     //! \note The owner or operating system will dequeue these and
     //! put each one into the payload of a lower-layer datagram (usually Internet datagrams (IP),
     //! but could also be user datagrams (UDP) or any other kind).
     std::queue<TCPSegment> &segments_out() { return _segments_out; }
 
+    //! \brief Has the three-way handshake completed (the peer's SYN received and our SYN acknowledged)?
+    bool handshake_complete() const {
+        return _receiver.ackno().has_value() and _sender.next_seqno_absolute() > _sender.bytes_in_flight();
+    }
+
     //! \brief Is the connection still alive in any way?
     //! \returns `true` if either stream is still running or if the TCPConnection is lingering
     //! after both streams have finished (e.g. to ACK retransmissions from the peer)
@@ -1,11 +1,25 @@
 #include "fd_adapter.hh"
 
+#include <arpa/inet.h>
+#include <cstring>
 #include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
 #include <stdexcept>
 #include <utility>
 
 using namespace std;
 
+bool FdAdapterBase::readable(const FileDescriptor &fd) {
+    pollfd pfd{fd.fd_num(), POLLIN, 0};
+    return SystemCall("poll", ::poll(&pfd, 1, 0)) > 0 and (pfd.revents & POLLIN);
+}
+
+string FourTuple::to_string() const {
+    return Address::from_ipv4_numeric(local_address).ip() + ":" + ::to_string(local_port) + " -> " +
+           Address::from_ipv4_numeric(remote_address).ip() + ":" + ::to_string(remote_port);
+}
+
 //! \details This function first attempts to parse a TCP segment from the next UDP
 //! payload recv()d from the socket.
 //!
@@ -19,7 +33,11 @@ using namespace std;
 //! the result that future outgoing segments go to the sender of the SYN segment.
 //! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
 optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
-    auto datagram = _sock.recv();
+    auto received = _recv();
+    if (not received) {
+        return {};
+    }
+    auto &datagram = received.value();
 
     // is it for us?
     if (not listening() and (datagram.source_address != config().destination)) {
@@ -46,11 +64,95 @@ optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
 }
 
 //! Serialize a TCP segment and send it as the payload of a UDP datagram.
+//! A segment larger than the configured MSS is split and sent as several datagrams.
 //! \param[in] seg is the TCP segment to write
 void TCPOverUDPSocketAdapter::write(TCPSegment &seg) {
     seg.header().sport = config().source.port();
     seg.header().dport = config().destination.port();
-    _sock.sendto(config().destination, seg.serialize(0));
+    while (seg.payload().size() > split_size()) {
+        _sendto(config().destination, seg.split_front(split_size()).serialize(0));
+    }
+    _sendto(config().destination, seg.serialize(0));
+}
+
+//! \details Unlike read(), this accepts a segment from any sender. UDP serves as a tunnel between
+//! hosts here: the ports of the FourTuple are the TCP ports in the segment header, so many connections
+//! can share one pair of UDP sockets, and write_to() sends to the UDP port of the configured destination.
+//! \param[out] tuple is set to the connection the segment belongs to
+//! \returns a std::optional<TCPSegment> that is empty if the payload was not a valid TCP segment
+optional<TCPSegment> TCPOverUDPSocketAdapter::read_any(FourTuple &tuple) {
+    auto received = _recv();
+    if (not received) {
+        return {};
+    }
+    auto &datagram = received.value();
+
+    TCPSegment seg;
+    if (ParseResult::NoError != seg.parse(move(datagram.payload), 0)) {
+        return {};
+    }
+
+    tuple.local_address = config().source.ipv4_numeric();
+    tuple.local_port = seg.header().dport;
+    tuple.remote_address = datagram.source_address.ipv4_numeric();
+    tuple.remote_port = seg.header().sport;
+    return seg;
+}
+
+//! A segment larger than the configured MSS is split and sent as several datagrams.
+//! \param[in] tuple is the connection the segment belongs to
+//! \param[in] seg is the TCP segment to write
+void TCPOverUDPSocketAdapter::write_to(const FourTuple &tuple, TCPSegment &seg) {
+    // the tunnel's UDP port, read straight out of the sockaddr (Address::port() goes through getnameinfo)
+    sockaddr_in destination{};
+    memcpy(&destination, static_cast<const sockaddr *>(config().destination), sizeof(destination));
+    destination.sin_addr.s_addr = htobe32(tuple.remote_address);
+    const Address peer{reinterpret_cast<const sockaddr *>(&destination), sizeof(destination)};
+
+    seg.header().sport = tuple.local_port;
+    seg.header().dport = tuple.remote_port;
+    while (seg.payload().size() > split_size()) {
+        _sendto(peer, seg.split_front(split_size()).serialize(0));
+    }
+    _sendto(peer, seg.serialize(0));
+}
+
+//! \param[in] depth is the most datagrams read, or written, by one system call
+bool TCPOverUDPSocketAdapter::enable_io_uring(const size_t depth) {
+    _ring = DatagramRing::make(_sock, true, depth);
+    return _ring != nullptr;
+}
+
+void TCPOverUDPSocketAdapter::flush() {
+    if (_ring) {
+        _ring->flush();
+    }
+}
+
+optional<UDPSocket::received_datagram> TCPOverUDPSocketAdapter::_recv() {
+    UDPSocket::received_datagram datagram{{nullptr, 0}, ""};
+    if (not _ring) {
+        // a non-blocking read finds out whether more are waiting at no extra cost
+        _drained = not _sock.try_recv(datagram);
+        if (_drained) {
+            return {};
+        }
+        return datagram;
+    }
+    auto payload = _ring->read(&datagram.source_address);
+    if (not payload) {
+        return {};
+    }
+    datagram.payload = move(payload.value());
+    return datagram;
+}
+
+void TCPOverUDPSocketAdapter::_sendto(const Address &destination, const BufferViewList &payload) {
+    if (_ring) {
+        _ring->write(payload, &destination);
+    } else {
+        _sock.sendto(destination, payload);
+    }
 }
 
 //! Specialize LossyFdAdapter to TCPOverUDPSocketAdapter
@@ -1,6 +1,7 @@
 #ifndef SPONGE_LIBSPONGE_FD_ADAPTER_HH
 #define SPONGE_LIBSPONGE_FD_ADAPTER_HH
 
+#include "datagram_ring.hh"
 #include "file_descriptor.hh"
 #include "lossy_fd_adapter.hh"
 #include "socket.hh"
@@ -8,6 +9,8 @@
 #include "tcp_header.hh"
 #include "tcp_segment.hh"
 
+#include <algorithm>
+#include <memory>
 #include <optional>
 #include <utility>
 
@@ -21,6 +24,12 @@ class FdAdapterBase {
   protected:
     FdAdapterConfig &config_mutable() { return _cfg; }
 
+    //! \returns `true` if `fd` can be read without blocking
+    static bool readable(const FileDescriptor &fd);
+
+    //! \returns the payload size that writes split segments into: config().mss, but at least one byte
+    size_t split_size() const { return std::max(_cfg.mss, size_t(1)); }
+
   public:
     //! \brief Set the listening flag
     //! \param[in] l is the new value for the flag
@@ -40,6 +49,12 @@ class FdAdapterBase {
 
     //! Called periodically when time elapses
     void tick(const size_t) {}
+
+    //! \returns ms until tick() has something to do, or an empty value if it never does
+    std::optional<size_t> ms_until_deadline() const { return {}; }
+
+    //! Send what write() and write_to() have prepared; an adapter that does not batch its writes has sent it already
+    void flush() {}
 };
 
 //! \brief A FD adaptor that reads and writes TCP segments in UDP payloads
@@ -47,16 +62,46 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
   private:
     UDPSocket _sock;
 
+    //! Batches the reads and writes of `_sock`, once enable_io_uring() has been called
+    std::unique_ptr<DatagramRing> _ring{};
+
+    //! Without io_uring, did the last read find no datagram waiting?
+    bool _drained{false};
+
+    //! Receive a datagram, or an empty value if none was waiting (reads do not block)
+    std::optional<UDPSocket::received_datagram> _recv();
+
+    //! Send a datagram, or prepare it to be sent by flush() (with io_uring)
+    void _sendto(const Address &destination, const BufferViewList &payload);
+
   public:
     //! Construct from a UDPSocket sliced into a FileDescriptor
     explicit TCPOverUDPSocketAdapter(UDPSocket &&sock) : _sock(std::move(sock)) {}
 
+    //! Read and write the socket through io_uring, up to `depth` datagrams per system call
+    //! \note makes the socket non-blocking; writes are only sent by flush()
+    //! \returns `false` if io_uring is not available, and the socket is then still read and written directly
+    bool enable_io_uring(const size_t depth = DatagramRing::DEFAULT_DEPTH);
+
     //! Attempts to read and return a TCP segment related to the current connection from a UDP payload
     std::optional<TCPSegment> read();
 
     //! Writes a TCP segment into a UDP payload
     void write(TCPSegment &seg);
 
+    //! Reads a TCP segment for any connection from a UDP payload, and the FourTuple it belongs to
+    std::optional<TCPSegment> read_any(FourTuple &tuple);
+
+    //! Writes a TCP segment of the connection identified by `tuple` into a UDP payload
+    void write_to(const FourTuple &tuple, TCPSegment &seg);
+
+    //! Send the datagrams that write() and write_to() have prepared, with io_uring
+    void flush();
+
+    //! \returns `true` if a datagram may be waiting: unless the last read found none (or, with io_uring,
+    //! its batch was not full and has been consumed), the next read tries
+    bool datagram_waiting() const { return _ring ? _ring->datagram_waiting() : not _drained; }
+
     //! Access the underlying UDP socket
     operator UDPSocket &() { return _sock; }
 
@@ -56,6 +56,24 @@ class LossyFdAdapter {
         return _adapter.write(seg);
     }
 
+    //! \brief Read a segment for any connection from the underlying AdapterT, potentially dropping it
+    //! \param[out] tuple is set to the connection the segment belongs to
+    std::optional<TCPSegment> read_any(FourTuple &tuple) {
+        auto ret = _adapter.read_any(tuple);
+        if (_should_drop(false)) {
+            return {};
+        }
+        return ret;
+    }
+
+    //! \brief Write a segment of the connection identified by `tuple`, or drop it
+    void write_to(const FourTuple &tuple, TCPSegment &seg) {
+        if (_should_drop(true)) {
+            return;
+        }
+        return _adapter.write_to(tuple, seg);
+    }
+
     //! \name
     //! Passthrough functions to the underlying AdapterT instance
 
@@ -66,6 +84,13 @@ class LossyFdAdapter {
     void tick(const size_t ms_since_last_tick) {
         _adapter.tick(ms_since_last_tick);
     }  //!< FdAdapterBase::tick passthrough
+    std::optional<size_t> ms_until_deadline() const {
+        return _adapter.ms_until_deadline();
+    }                                   //!< FdAdapterBase::ms_until_deadline passthrough
+    void flush() { _adapter.flush(); }  //!< FdAdapterBase::flush passthrough
+    bool datagram_waiting() const {
+        return _adapter.datagram_waiting();
+    }  //!< AdapterT::datagram_waiting passthrough
     //!@}
 };
 
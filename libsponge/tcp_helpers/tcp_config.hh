@@ -6,11 +6,16 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <optional>
+#include <string>
 
 //! Config for TCP sender and receiver
 class TCPConfig {
   public:
+    //! Congestion control algorithm of the sender
+    enum class Congestion { None, Reno, Cubic };
+
     static constexpr size_t DEFAULT_CAPACITY = 64000;  //!< Default capacity
     static constexpr size_t MAX_PAYLOAD_SIZE = 1452;   //!< Max TCP payload that fits in either IPv4 or UDP datagram
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
@@ -20,6 +25,20 @@ class TCPConfig {
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
     std::optional<WrappingInt32> fixed_isn{};
+    bool bitmap_reassembly = false;           //!< Reassemble in a capacity-sized ring buffer instead of a map of segments
+    size_t mss = MAX_PAYLOAD_SIZE;            //!< Max payload of a segment on the wire, in bytes (at least 1)
+    size_t super_segment_size = 0;  //!< If larger than `mss`, segments carry up to this many bytes and the adapter splits them
+    Congestion congestion = Congestion::None;  //!< Sender congestion control (None: only the receive window limits it)
+    bool fast_retransmit = false;  //!< Retransmit on three duplicate acks and recover as in NewReno (RFC 6582)
+    bool sack = false;             //!< Offer selective acknowledgments (RFC 2018), used if the peer offers them too
+    bool window_scaling = false;  //!< Offer window scaling (RFC 7323) so windows can exceed 64 KiB, if the peer offers it too
+    bool timestamps = false;  //!< Offer timestamps (RFC 7323) for RTT measurement and PAWS, if the peer offers them too
+    bool adaptive_rto = false;  //!< Adapt the retransmission timeout to measured RTTs (RFC 6298) instead of `rt_timeout`
+    size_t rto_min = 200;       //!< Lower bound of the adaptive retransmission timeout, in milliseconds
+    size_t rto_max = 60000;     //!< Upper bound of the adaptive retransmission timeout, in milliseconds
+    size_t ack_delay = 0;  //!< Delay of ACKs for in-order data, in milliseconds (0: ACK every segment at once)
+    bool nagle = false;    //!< Hold back segments smaller than the max payload while data is in flight (RFC 896)
+    bool pacing = false;   //!< Spread new segments over the RTT at cwnd/SRTT, once `adaptive_rto` has measured an RTT
 };
 
 //! Config for classes derived from FdAdapter
@@ -30,6 +49,36 @@ class FdAdapterConfig {
 
     uint16_t loss_rate_dn = 0;  //!< Downlink loss rate (for LossyFdAdapter)
     uint16_t loss_rate_up = 0;  //!< Uplink loss rate (for LossyFdAdapter)
+
+    size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;  //!< Larger segments are split into pieces of this payload size (at least 1) on write
+};
+
+//! \brief The local and remote addresses and ports that identify one TCP connection
+//! \details Addresses are IPv4 addresses in host byte order. Used by TCPEngine to demultiplex
+//! the segments read from one adapter to many TCPConnection objects.
+struct FourTuple {
+    uint32_t local_address{0};   //!< Local IPv4 address
+    uint16_t local_port{0};      //!< Local port
+    uint32_t remote_address{0};  //!< Remote IPv4 address
+    uint16_t remote_port{0};     //!< Remote port
+
+    bool operator==(const FourTuple &other) const {
+        return local_address == other.local_address and local_port == other.local_port and
+               remote_address == other.remote_address and remote_port == other.remote_port;
+    }
+    bool operator!=(const FourTuple &other) const { return not operator==(other); }
+
+    //! "1.2.3.4:5 -> 6.7.8.9:10", for debugging output
+    std::string to_string() const;
+};
+
+//! Hash of a FourTuple, for keying a connection table
+struct FourTupleHash {
+    size_t operator()(const FourTuple &t) const {
+        const uint64_t addresses = (uint64_t(t.local_address) << 32) | t.remote_address;
+        const uint32_t ports = (uint32_t(t.local_port) << 16) | t.remote_port;
+        return std::hash<uint64_t>{}(addresses ^ (uint64_t(ports) * 0x9e3779b97f4a7c15));
+    }
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_CONFIG_HH
@@ -0,0 +1,319 @@
+#include "tcp_engine.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+//! most datagrams read in one go before the connections that received them are serviced
+static constexpr size_t MAX_READ_BURST = 64;
+
+//! most datagrams read in one wakeup, so that a steady stream of them does not hold off the timers
+static constexpr size_t MAX_READ_PER_WAKEUP = 4 * MAX_READ_BURST;
+
+//! \param[in] datagram_interface is the adapter shared by all connections
+//! \param[in] handler is called for each connection that has handled segments or a tick
+template <typename AdaptT>
+TCPEngine<AdaptT>::TCPEngine(AdaptT &&datagram_interface, const HandlerT &handler)
+    : _datagram_adapter(move(datagram_interface))
+    , _handler(handler)
+    , _timer_wheel(timestamp_ms())
+    , _adapter_last_tick(timestamp_ms()) {
+    _eventloop.add_rule(_datagram_adapter, Direction::In, [&] { _read_segments(); });
+}
+
+//! \param[in] config is the TCPConfig for the new connection
+//! \param[in] tuple identifies the connection; its local port must not be in use with the same peer
+//! \returns the new connection, which has sent its SYN
+template <typename AdaptT>
+TCPConnection &TCPEngine<AdaptT>::connect(const TCPConfig &config, const FourTuple &tuple) {
+    const uint64_t now = timestamp_ms();
+    const auto [it, inserted] = _connections.try_emplace(tuple, config, Connection::Stage::Accepted, nullopt, now);
+    if (not inserted) {
+        throw runtime_error("TCPEngine::connect(): connection " + tuple.to_string() + " already exists");
+    }
+    it->second.tcp.connect();
+    _service(it->first, it->second, now);
+    _datagram_adapter.flush();
+    return it->second.tcp;
+}
+
+//! \param[in] config is the TCPConfig for connections accepted on `port`
+//! \param[in] port is the local port to accept connections on
+//! \param[in] backlog is the most connections kept in each of the SYN queue and the accept queue
+template <typename AdaptT>
+void TCPEngine<AdaptT>::listen(const TCPConfig &config, const uint16_t port, const size_t backlog) {
+    if (not _listeners.try_emplace(port, Listener{config, backlog}).second) {
+        throw runtime_error("TCPEngine::listen(): already listening on port " + to_string(port));
+    }
+}
+
+//! \param[in] port is the listening port
+template <typename AdaptT>
+optional<FourTuple> TCPEngine<AdaptT>::accept(const uint16_t port) {
+    Listener &listener = _listeners.at(port);
+    while (not listener.accept_queue.empty()) {
+        const FourTuple tuple = listener.accept_queue.front();
+        listener.accept_queue.pop_front();
+        // the connection may have been reset, or replaced by a newer one, since it was queued
+        const auto it = _connections.find(tuple);
+        if (it != _connections.end() and it->second.stage == Connection::Stage::Queued) {
+            it->second.stage = Connection::Stage::Accepted;
+            listener.counters.accepted++;
+            // the handler takes the data that arrived while the connection was queued
+            const uint64_t now = timestamp_ms();
+            _tick(it->second, now);
+            if (_service(tuple, it->second, now)) {
+                _erase(tuple);
+            }
+            _datagram_adapter.flush();
+            return tuple;
+        }
+    }
+    return {};
+}
+
+//! \param[in] tuple identifies the connection
+template <typename AdaptT>
+void TCPEngine<AdaptT>::flush(const FourTuple &tuple) {
+    const auto it = _connections.find(tuple);
+    if (it == _connections.end()) {
+        return;
+    }
+    // what was written since the last tick is stamped with the current time
+    const uint64_t now = timestamp_ms();
+    _tick(it->second, now);
+    if (_service(tuple, it->second, now, false)) {
+        _erase(tuple);
+    }
+    _datagram_adapter.flush();
+}
+
+//! \details The connection is ticked to the current time first, so that what is written to it is
+//! stamped with the time it is sent (its segments are only sent by flush(), though)
+template <typename AdaptT>
+TCPConnection *TCPEngine<AdaptT>::find(const FourTuple &tuple) {
+    const auto it = _connections.find(tuple);
+    if (it == _connections.end()) {
+        return nullptr;
+    }
+    _tick(it->second, timestamp_ms());
+    return &it->second.tcp;
+}
+
+template <typename AdaptT>
+typename TCPEngine<AdaptT>::Connection *TCPEngine<AdaptT>::_demultiplex(const FourTuple &tuple,
+                                                                        const TCPSegment &seg) {
+    const auto it = _connections.find(tuple);
+    if (it != _connections.end()) {
+        return &it->second;
+    }
+
+    // only a SYN can open a new connection, and only to a listening port with room in its queues
+    const auto listener = _listeners.find(tuple.local_port);
+    if (listener == _listeners.end() or not seg.header().syn or seg.header().ack or seg.header().rst) {
+        return nullptr;
+    }
+    Listener &l = listener->second;
+    if (l.half_open >= l.backlog or l.accept_queue.size() >= l.backlog) {
+        l.counters.syns_dropped++;
+        return nullptr;
+    }
+    l.half_open++;
+    l.counters.syns_received++;
+    return &_connections.try_emplace(tuple, l.config, Connection::Stage::SynReceived, tuple.local_port, timestamp_ms())
+                .first->second;
+}
+
+template <typename AdaptT>
+void TCPEngine<AdaptT>::_read_segments() {
+    // NOTE: an adapter that reads in batches may hold datagrams the fd no longer signals, so read until
+    // none is left, or up to the cap (and then wait_next_event() comes back for the rest without sleeping)
+    bool waiting = true;
+    size_t total = 0;
+    while (waiting and total < MAX_READ_PER_WAKEUP) {
+        // group the burst by connection, so each connection ACKs its part of the burst once
+        vector<pair<FourTuple, vector<TCPSegment>>> bursts;
+        size_t datagrams = 0;
+        const uint64_t now = timestamp_ms();
+        _tick_adapter(now);
+        do {
+            FourTuple tuple;
+            auto seg = _datagram_adapter.read_any(tuple);
+            ++datagrams;
+            waiting = _datagram_adapter.datagram_waiting();
+            if (not seg or _demultiplex(tuple, seg.value()) == nullptr) {
+                continue;
+            }
+            auto burst = find_if(bursts.begin(), bursts.end(), [&](const auto &b) { return b.first == tuple; });
+            if (burst == bursts.end()) {
+                burst = bursts.emplace(bursts.end(), tuple, vector<TCPSegment>{});
+            }
+            burst->second.push_back(move(seg.value()));
+        } while (datagrams < MAX_READ_BURST and waiting);
+        total += datagrams;
+
+        for (const auto &[tuple, segments] : bursts) {
+            Connection &connection = _connections.at(tuple);
+            _tick(connection, now);
+            connection.tcp.segments_received(segments);
+            if (_service(tuple, connection, now)) {
+                _erase(tuple);
+            }
+        }
+        // reading may have taught an Ethernet adapter new ARP entries
+        _schedule_adapter(now);
+        _datagram_adapter.flush();
+    }
+    _datagrams_left = waiting;
+}
+
+template <typename AdaptT>
+void TCPEngine<AdaptT>::_tick(Connection &connection, const uint64_t now) {
+    if (now > connection.last_tick) {
+        connection.tcp.tick(now - connection.last_tick);
+        connection.last_tick = now;
+    }
+}
+
+template <typename AdaptT>
+void TCPEngine<AdaptT>::_connection_timer_expired(const FourTuple &tuple) {
+    Connection &connection = _connections.at(tuple);
+    connection.timer.reset();
+    const uint64_t now = timestamp_ms();
+    _tick(connection, now);
+    if (_service(tuple, connection, now)) {
+        _erase(tuple);
+    }
+}
+
+template <typename AdaptT>
+void TCPEngine<AdaptT>::_tick_adapter(const uint64_t now) {
+    if (now > _adapter_last_tick) {
+        _datagram_adapter.tick(now - _adapter_last_tick);
+        _adapter_last_tick = now;
+    }
+}
+
+template <typename AdaptT>
+void TCPEngine<AdaptT>::_adapter_timer_expired() {
+    _adapter_timer.reset();
+    const uint64_t now = timestamp_ms();
+    _tick_adapter(now);
+    _schedule_adapter(now);
+}
+
+template <typename AdaptT>
+void TCPEngine<AdaptT>::_schedule_adapter(const uint64_t now) {
+    if (_adapter_timer.has_value()) {
+        _timer_wheel.cancel(_adapter_timer.value());
+        _adapter_timer.reset();
+    }
+    if (const auto ms = _datagram_adapter.ms_until_deadline()) {
+        _adapter_timer = _timer_wheel.schedule(now + ms.value(), [this] { _adapter_timer_expired(); });
+    }
+}
+
+template <typename AdaptT>
+void TCPEngine<AdaptT>::_erase(const FourTuple &tuple) {
+    const auto it = _connections.find(tuple);
+    if (it->second.timer.has_value()) {
+        _timer_wheel.cancel(it->second.timer.value());
+    }
+    _connections.erase(it);
+}
+
+//! \param[in] now is the current time
+//! \param[in] call_handler is `false` to only write the connection's segments
+template <typename AdaptT>
+bool TCPEngine<AdaptT>::_service(const FourTuple &tuple,
+                                 Connection &connection,
+                                 const uint64_t now,
+                                 const bool call_handler) {
+    TCPConnection &tcp = connection.tcp;
+    if (connection.stage == Connection::Stage::SynReceived) {
+        Listener &listener = _listeners.at(connection.listen_port.value());
+        if (tcp.handshake_complete()) {
+            listener.half_open--;
+            listener.accept_queue.push_back(tuple);
+            connection.stage = Connection::Stage::Queued;
+        } else if (not tcp.active()) {
+            listener.half_open--;
+        }
+    }
+
+    if (call_handler and connection.stage == Connection::Stage::Accepted) {
+        _handler(tuple, tcp);
+    }
+    const bool wrote = not tcp.segments_out().empty();
+    if (wrote) {
+        // the adapter stamps the ARP entries and requests it makes with its own clock
+        _tick_adapter(now);
+    }
+    while (not tcp.segments_out().empty()) {
+        _datagram_adapter.write_to(tuple, tcp.segments_out().front());
+        tcp.segments_out().pop();
+    }
+    if (wrote) {
+        _schedule_adapter(now);
+    }
+
+    if (connection.timer.has_value()) {
+        _timer_wheel.cancel(connection.timer.value());
+        connection.timer.reset();
+    }
+    if (const auto ms = tcp.ms_until_deadline()) {
+        connection.timer =
+            _timer_wheel.schedule(now + ms.value(), [this, tuple] { _connection_timer_expired(tuple); });
+    }
+    return not tcp.active();
+}
+
+//! \param[in] timeout_ms is the longest time to wait for a datagram, or negative to wait for one
+//! (or the next deadline) indefinitely
+//! \returns the EventLoop::Result of waiting for datagrams
+template <typename AdaptT>
+EventLoop::Result TCPEngine<AdaptT>::wait_next_event(const int timeout_ms) {
+    int timeout = timeout_ms;
+    if (const auto deadline = _timer_wheel.next_deadline()) {
+        const uint64_t now = timestamp_ms();
+        const int until_deadline = deadline.value() > now ? int(min<uint64_t>(deadline.value() - now, INT_MAX)) : 0;
+        timeout = timeout < 0 ? until_deadline : min(timeout, until_deadline);
+    }
+
+    if (_datagrams_left) {
+        timeout = 0;
+    }
+
+    auto ret = _eventloop.wait_next_event(timeout);
+    if (ret == EventLoop::Result::Exit) {
+        return ret;
+    }
+    if (ret == EventLoop::Result::Timeout and _datagrams_left) {
+        _read_segments();
+        ret = EventLoop::Result::Success;
+    }
+    _timer_wheel.advance(timestamp_ms());
+    _datagram_adapter.flush();
+    return ret;
+}
+
+//! Specialization of TCPEngine for TCPOverUDPSocketAdapter
+template class TCPEngine<TCPOverUDPSocketAdapter>;
+
+//! Specialization of TCPEngine for TCPOverIPv4OverTunFdAdapter
+template class TCPEngine<TCPOverIPv4OverTunFdAdapter>;
+
+//! Specialization of TCPEngine for TCPOverIPv4OverEthernetAdapter
+template class TCPEngine<TCPOverIPv4OverEthernetAdapter>;
+
+//! Specialization of TCPEngine for LossyTCPOverUDPSocketAdapter
+template class TCPEngine<LossyTCPOverUDPSocketAdapter>;
+
+//! Specialization of TCPEngine for LossyTCPOverIPv4OverTunFdAdapter
+template class TCPEngine<LossyTCPOverIPv4OverTunFdAdapter>;
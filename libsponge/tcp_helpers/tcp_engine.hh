@@ -0,0 +1,191 @@
+#ifndef SPONGE_LIBSPONGE_TCP_ENGINE_HH
+#define SPONGE_LIBSPONGE_TCP_ENGINE_HH
+
+#include "eventloop.hh"
+#include "fd_adapter.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+#include "tuntap_adapter.hh"
+#include "util/timer_wheel.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+//! Single-threaded driver for many TCPConnection objects that share one datagram adapter
+template <typename AdaptT>
+class TCPEngine {
+  public:
+    //! \brief Called for a connection after it has handled segments or a tick, and when it is accepted
+    //! \details The handler reads the connection's inbound stream and writes to its outbound stream.
+    //! It is called once more after the connection stops being active, just before it is removed.
+    using HandlerT = std::function<void(const FourTuple &, TCPConnection &)>;
+
+    //! Default number of connections that a listening port keeps in each of its SYN and accept queues
+    static constexpr size_t DEFAULT_BACKLOG = 128;
+
+    //! Counts of the handshakes seen by a listening port
+    struct ListenCounters {
+        size_t syns_received{0};  //!< SYNs that opened a connection
+        size_t syns_dropped{0};   //!< SYNs dropped because the SYN or accept queue was full
+        size_t accepted{0};       //!< connections handed out by accept()
+    };
+
+  private:
+    //! A local port that accepts connections
+    struct Listener {
+        TCPConfig config;                          //!< configuration of the connections it creates
+        size_t backlog;                            //!< most connections in each of the SYN and accept queues
+        size_t half_open{0};                       //!< connections still in the three-way handshake
+        std::deque<FourTuple> accept_queue{};      //!< established connections waiting for accept()
+        ListenCounters counters{};                 //!< handshakes seen so far
+    };
+
+    //! An entry of the connection table
+    struct Connection {
+        //! How far a connection opened by a peer has got towards the application
+        enum class Stage { SynReceived, Queued, Accepted };
+
+        TCPConnection tcp;                              //!< the connection itself
+        Stage stage;                                    //!< connections opened with connect() start out Accepted
+        std::optional<uint16_t> listen_port;            //!< the listening port that created the connection
+        uint64_t last_tick;                             //!< time at which the connection was last ticked
+        std::optional<TimerWheel::TimerId> timer{};     //!< timer for the connection's next deadline
+
+        Connection(const TCPConfig &config, const Stage s, const std::optional<uint16_t> port, const uint64_t now)
+            : tcp(config), stage(s), listen_port(port), last_tick(now) {}
+    };
+
+    //! Adapter to the underlying datagram socket (e.g., UDP or IP), shared by all connections
+    AdaptT _datagram_adapter;
+
+    //! Called for each connection that has handled events
+    HandlerT _handler;
+
+    //! Connection table, keyed by the addresses and ports of each connection
+    std::unordered_map<FourTuple, Connection, FourTupleHash> _connections{};
+
+    //! Local ports that accept new connections
+    std::unordered_map<uint16_t, Listener> _listeners{};
+
+    //! eventloop that waits for inbound datagrams
+    EventLoop _eventloop{};
+
+    //! Deadlines of the connections and the adapter, in ms as returned by timestamp_ms()
+    TimerWheel _timer_wheel;
+
+    //! Time at which the adapter was last ticked
+    uint64_t _adapter_last_tick;
+
+    //! Timer for the adapter's next deadline
+    std::optional<TimerWheel::TimerId> _adapter_timer{};
+
+    //! Did the last read stop at its cap with datagrams still waiting?
+    bool _datagrams_left{false};
+
+    //! Read bursts of datagrams (up to a cap) and hand each connection its segments
+    void _read_segments();
+
+    //! Tick a connection by the time since its last tick
+    void _tick(Connection &connection, const uint64_t now);
+
+    //! Tick the connection whose deadline has come, and service it
+    void _connection_timer_expired(const FourTuple &tuple);
+
+    //! Tick the adapter by the time since its last tick, before it reads or writes
+    void _tick_adapter(const uint64_t now);
+
+    //! Tick the adapter, whose deadline has come
+    void _adapter_timer_expired();
+
+    //! Replace the adapter's timer with one for its current deadline
+    void _schedule_adapter(const uint64_t now);
+
+    //! Find the connection a segment belongs to, creating it if the segment is a SYN that a listener admits
+    Connection *_demultiplex(const FourTuple &tuple, const TCPSegment &seg);
+
+    //! Queue a finished handshake for accept(), call the handler, write the connection's segments,
+    //! and schedule its next deadline
+    //! \returns `true` if the connection is finished and should be removed from the table
+    bool _service(const FourTuple &tuple, Connection &connection, const uint64_t now, const bool call_handler = true);
+
+    //! Cancel the connection's timer and remove it from the table
+    void _erase(const FourTuple &tuple);
+
+  public:
+    //! Construct from the adapter that all connections will read and write datagrams through
+    TCPEngine(AdaptT &&datagram_interface, const HandlerT &handler);
+
+    //! Open a connection identified by `tuple`
+    TCPConnection &connect(const TCPConfig &config, const FourTuple &tuple);
+
+    //! Accept connections to a local port, keeping up to `backlog` connections in each of its queues
+    void listen(const TCPConfig &config, const uint16_t port, const size_t backlog = DEFAULT_BACKLOG);
+
+    //! Take the oldest established connection to `port` off its accept queue, and call the handler for it
+    //! \returns the FourTuple of the connection, or an empty value if no connection is waiting
+    std::optional<FourTuple> accept(const uint16_t port);
+
+    //! Send what has been written to a connection outside the handler, e.g. just after connect()
+    void flush(const FourTuple &tuple);
+
+    //! \returns the handshakes seen by the listening `port`
+    const ListenCounters &listen_counters(const uint16_t port) const { return _listeners.at(port).counters; }
+
+    //! Wait up to `timeout_ms` (or forever, if negative) for datagrams or the next deadline, hand the
+    //! datagrams to their connections, and tick the connections whose deadline has come
+    //! \note the handler must not call connect(), listen(), accept() or flush()
+    EventLoop::Result wait_next_event(const int timeout_ms);
+
+    //! \returns the connection identified by `tuple` (ticked to the current time), or `nullptr`
+    TCPConnection *find(const FourTuple &tuple);
+
+    //! \returns the number of connections in the table
+    size_t connection_count() const { return _connections.size(); }
+
+    //! \returns the number of connections (and adapters) waiting for a deadline
+    size_t timer_count() const { return _timer_wheel.size(); }
+
+    //! \returns the underlying adapter, e.g. to set its configuration
+    AdaptT &adapter() { return _datagram_adapter; }
+};
+
+using TCPOverUDPEngine = TCPEngine<TCPOverUDPSocketAdapter>;
+using TCPOverIPv4Engine = TCPEngine<TCPOverIPv4OverTunFdAdapter>;
+using TCPOverIPv4OverEthernetEngine = TCPEngine<TCPOverIPv4OverEthernetAdapter>;
+
+using LossyTCPOverUDPEngine = TCPEngine<LossyTCPOverUDPSocketAdapter>;
+using LossyTCPOverIPv4Engine = TCPEngine<LossyTCPOverIPv4OverTunFdAdapter>;
+
+//! \class TCPEngine
+//! Where a TCPSpongeSocket owns one TCPConnection, one adapter and one thread, a TCPEngine
+//! runs any number of TCPConnection objects over a single adapter from the caller's thread.
+//!
+//! Each datagram read from the adapter is parsed along with its FourTuple, and the segment is
+//! given to the TCPConnection with that FourTuple in the connection table. Segments for unknown
+//! connections are dropped, except for SYNs to a port passed to listen(). The segments read in one
+//! burst are handed to each connection with TCPConnection::segments_received, so a burst gets one ACK.
+//!
+//! A listening port works like the kernel's: each SYN creates a connection in the SYN queue, which
+//! moves to the accept queue when the three-way handshake completes, and leaves it through accept().
+//! When either queue holds `backlog` connections, further SYNs are dropped, and the peers retransmit
+//! them later. Many handshakes can be in progress at once, and the port keeps listening.
+//!
+//! The application does its work in the handler, which sees each connection after it has
+//! received segments and after every tick, once the connection has been accepted (or was opened
+//! with connect()). Connections are removed from the table once they are no longer active.
+//!
+//! A connection is only ticked when it has something to do: after servicing it, the engine asks
+//! TCPConnection::ms_until_deadline() when its next retransmission, delayed ACK, paced segment or
+//! end of TIME_WAIT is due, and files that deadline in a TimerWheel. The adapter's deadline (the ARP
+//! cache of an Ethernet adapter) is filed the same way. wait_next_event() sleeps until the earliest
+//! deadline, so an idle connection costs nothing until a segment arrives for it. A connection (or
+//! the adapter) is also ticked to the current time whenever it is about to send or receive, so its
+//! clock is never behind when it stamps a segment, an RTT sample or an ARP entry.
+
+#endif  // SPONGE_LIBSPONGE_TCP_ENGINE_HH
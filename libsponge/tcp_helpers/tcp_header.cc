@@ -4,6 +4,55 @@
 
 using namespace std;
 
+//! option kinds
+static constexpr uint8_t OPTION_EOL = 0;
+static constexpr uint8_t OPTION_NOP = 1;
+static constexpr uint8_t OPTION_WINDOW_SCALE = 3;
+static constexpr uint8_t OPTION_SACK_PERMITTED = 4;
+static constexpr uint8_t OPTION_SACK = 5;
+static constexpr uint8_t OPTION_TIMESTAMPS = 8;
+
+//! the options area of a header is at most 40 bytes
+static constexpr size_t MAX_OPTIONS_LENGTH = 40;
+
+//! serialize the options of a header, padded to a multiple of four bytes
+static string serialize_options(const TCPHeader &header) {
+    string ret;
+    if (header.window_scale.has_value()) {
+        NetUnparser::u8(ret, OPTION_NOP);
+        NetUnparser::u8(ret, OPTION_WINDOW_SCALE);
+        NetUnparser::u8(ret, 3);
+        NetUnparser::u8(ret, header.window_scale.value());
+    }
+    if (header.sack_permitted) {
+        NetUnparser::u8(ret, OPTION_NOP);
+        NetUnparser::u8(ret, OPTION_NOP);
+        NetUnparser::u8(ret, OPTION_SACK_PERMITTED);
+        NetUnparser::u8(ret, 2);
+    }
+    if (header.timestamps.has_value()) {
+        NetUnparser::u8(ret, OPTION_NOP);
+        NetUnparser::u8(ret, OPTION_NOP);
+        NetUnparser::u8(ret, OPTION_TIMESTAMPS);
+        NetUnparser::u8(ret, 10);
+        NetUnparser::u32(ret, header.timestamps->first);
+        NetUnparser::u32(ret, header.timestamps->second);
+    }
+    // the SACK blocks go last, as many as fit in the space left
+    if (not header.sack.empty() and ret.size() + 12 <= MAX_OPTIONS_LENGTH) {
+        const size_t blocks = min(header.sack.size(), (MAX_OPTIONS_LENGTH - ret.size() - 4) / 8);
+        NetUnparser::u8(ret, OPTION_NOP);
+        NetUnparser::u8(ret, OPTION_NOP);
+        NetUnparser::u8(ret, OPTION_SACK);
+        NetUnparser::u8(ret, 2 + 8 * blocks);
+        for (size_t i = 0; i < blocks; i++) {
+            NetUnparser::u32(ret, header.sack[i].first.raw_value());
+            NetUnparser::u32(ret, header.sack[i].second.raw_value());
+        }
+    }
+    return ret;
+}
+
 //! \param[in,out] p is a NetParser from which the TCP fields will be extracted
 //! \returns a ParseResult indicating success or the reason for failure
 //! \details It is important to check for (at least) the following potential errors
@@ -37,8 +86,53 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    // parse the options, skipping unknown ones; a malformed option ends the option list
+    window_scale.reset();
+    sack_permitted = false;
+    sack.clear();
+    timestamps.reset();
+    size_t options_left = doff * 4 - TCPHeader::LENGTH;
+    while (options_left > 0 and not p.error()) {
+        const uint8_t kind = p.u8();
+        options_left--;
+        if (kind == OPTION_EOL) {
+            break;
+        }
+        if (kind == OPTION_NOP) {
+            continue;
+        }
+        if (options_left == 0) {
+            break;
+        }
+        const uint8_t len = p.u8();
+        options_left--;
+        if (len < 2 or len - 2u > options_left) {
+            break;
+        }
+        size_t body = len - 2;
+        options_left -= body;
+        if (kind == OPTION_WINDOW_SCALE and body == 1) {
+            window_scale = p.u8();
+            body = 0;
+        } else if (kind == OPTION_SACK_PERMITTED and body == 0) {
+            sack_permitted = true;
+        } else if (kind == OPTION_TIMESTAMPS and body == 8) {
+            const uint32_t tsval = p.u32();
+            const uint32_t tsecr = p.u32();
+            timestamps.emplace(tsval, tsecr);
+            body = 0;
+        } else if (kind == OPTION_SACK and body % 8 == 0) {
+            for (; body > 0; body -= 8) {
+                const WrappingInt32 left{p.u32()};
+                const WrappingInt32 right{p.u32()};
+                sack.emplace_back(left, right);
+            }
+        }
+        p.remove_prefix(body);
+    }
+
+    // skip anything extra in the header
+    p.remove_prefix(options_left);
 
     if (p.error()) {
         return p.get_error();
@@ -54,14 +148,17 @@ string TCPHeader::serialize() const {
         throw runtime_error("TCP header too short");
     }
 
+    const string options = serialize_options(*this);
+    const uint8_t data_offset = max<size_t>(doff, (TCPHeader::LENGTH + options.size()) / 4);
+
     string ret;
-    ret.reserve(4 * doff);
+    ret.reserve(4 * data_offset);
 
     NetUnparser::u16(ret, sport);              // source port
     NetUnparser::u16(ret, dport);              // destination port
     NetUnparser::u32(ret, seqno.raw_value());  // sequence number
     NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    NetUnparser::u8(ret, data_offset << 4);    // data offset
 
     const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
                          (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
@@ -72,7 +169,8 @@ string TCPHeader::serialize() const {
 
     NetUnparser::u16(ret, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    ret.append(options);          // options
+    ret.resize(4 * data_offset);  // expand header to advertised size
 
     return ret;
 }
@@ -89,14 +187,32 @@ string TCPHeader::to_string() const {
        << " fin: " << fin << '\n'
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
-       << "TCP uptr: " << +uptr << '\n';
+       << "TCP uptr: " << +uptr << '\n'
+       << "TCP window scale: " << (window_scale.has_value() ? std::to_string(window_scale.value()) : "none") << '\n'
+       << "TCP sack permitted: " << sack_permitted << '\n';
+    for (const auto &[left, right] : sack) {
+        ss << "TCP sack block: " << left << "-" << right << '\n';
+    }
+    if (timestamps.has_value()) {
+        ss << "TCP timestamps: " << timestamps->first << " " << timestamps->second << '\n';
+    }
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    if (window_scale.has_value()) {
+        ss << ",wscale=" << +window_scale.value();
+    }
+    for (const auto &[left, right] : sack) {
+        ss << ",sack=" << left << "-" << right;
+    }
+    if (timestamps.has_value()) {
+        ss << ",ts=" << timestamps->first << "/" << timestamps->second;
+    }
+    ss << ")";
     return ss.str();
 }
 
@@ -104,5 +220,6 @@ bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
            psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           uptr == other.uptr && window_scale == other.window_scale && sack_permitted == other.sack_permitted && sack == other.sack &&
+           timestamps == other.timestamps;
 }
@@ -4,10 +4,17 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <utility>
+#include <vector>
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note Only the window scale, SACK and timestamps options are supported, other options are skipped when parsing
 struct TCPHeader {
     static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t MAX_SACK_BLOCKS = 4;  //!< SACK blocks that fit in the 40 bytes of options
+    static constexpr size_t MAX_SACK_BLOCKS_WITH_TIMESTAMPS = 3;  //!< SACK blocks that fit next to the timestamps
+    static constexpr uint8_t MAX_WINDOW_SCALE = 14;  //!< Largest window shift allowed by [RFC 7323](\ref rfc::rfc7323)
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -50,10 +57,20 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! \name TCP options
+    //!@{
+    std::optional<uint8_t> window_scale{};  //!< window scale option (shift count), sent in SYN segments
+    bool sack_permitted = false;  //!< SACK-permitted option, sent in SYN segments ([RFC 2018](\ref rfc::rfc2018))
+    std::vector<std::pair<WrappingInt32, WrappingInt32>> sack{};  //!< SACK blocks: left edge and right edge (exclusive)
+    //! timestamps option: TSval and TSecr ([RFC 7323](\ref rfc::rfc7323))
+    std::optional<std::pair<uint32_t, uint32_t>> timestamps{};
+    //!@}
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
     //! Serialize the TCP fields
+    //! \note the data offset grows past `doff` if needed to hold the options
     std::string serialize() const;
 
     //! Return a string containing a header in human-readable format
@@ -70,17 +70,54 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
     return tcp_seg;
 }
 
+//! \details Unlike the single-connection overload, this accepts a segment from any peer to any port,
+//! as long as it is addressed to the adapter's source address (or the source address is "0").
+//! \param[out] tuple is set to the connection the segment belongs to
+//! \returns a std::optional<TCPSegment> that is empty if the datagram was not a valid TCP segment for us
+optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram &ip_dgram, FourTuple &tuple) {
+    const uint32_t local_address = config().source.ipv4_numeric();
+    if (local_address != 0 and ip_dgram.header().dst != local_address) {
+        return {};
+    }
+
+    if (ip_dgram.header().proto != IPv4Header::PROTO_TCP) {
+        return {};
+    }
+
+    TCPSegment tcp_seg;
+    if (ParseResult::NoError != tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum())) {
+        return {};
+    }
+
+    tuple.local_address = ip_dgram.header().dst;
+    tuple.local_port = tcp_seg.header().dport;
+    tuple.remote_address = ip_dgram.header().src;
+    tuple.remote_port = tcp_seg.header().sport;
+    return tcp_seg;
+}
+
 //! Takes a TCP segment, sets port numbers as necessary, and wraps it in an IPv4 datagram
 //! \param[in] seg is the TCP segment to convert
 InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
+    const FourTuple tuple{config().source.ipv4_numeric(),
+                          config().source.port(),
+                          config().destination.ipv4_numeric(),
+                          config().destination.port()};
+    return wrap_tcp_in_ip(tuple, seg);
+}
+
+//! Takes a TCP segment, sets the port numbers of its connection, and wraps it in an IPv4 datagram
+//! \param[in] tuple is the connection the segment belongs to
+//! \param[in] seg is the TCP segment to convert
+InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(const FourTuple &tuple, TCPSegment &seg) {
     // set the port numbers in the TCP segment
-    seg.header().sport = config().source.port();
-    seg.header().dport = config().destination.port();
+    seg.header().sport = tuple.local_port;
+    seg.header().dport = tuple.remote_port;
 
     // create an Internet Datagram and set its addresses and length
     InternetDatagram ip_dgram;
-    ip_dgram.header().src = config().source.ipv4_numeric();
-    ip_dgram.header().dst = config().destination.ipv4_numeric();
+    ip_dgram.header().src = tuple.local_address;
+    ip_dgram.header().dst = tuple.remote_address;
     ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().doff * 4 + seg.payload().size();
 
     // set payload, calculating TCP checksum using information from IP header
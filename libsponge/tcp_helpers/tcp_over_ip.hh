@@ -14,6 +14,12 @@ class TCPOverIPv4Adapter : public FdAdapterBase {
     std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram);
 
     InternetDatagram wrap_tcp_in_ip(TCPSegment &seg);
+
+    //! Unwrap a TCP segment for any connection to the local address, and the FourTuple it belongs to
+    std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram, FourTuple &tuple);
+
+    //! Wrap a TCP segment of the connection identified by `tuple` in an IPv4 datagram
+    InternetDatagram wrap_tcp_in_ip(const FourTuple &tuple, TCPSegment &seg);
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_OVER_IP_HH
@@ -3,6 +3,7 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <variant>
 
 using namespace std;
@@ -26,6 +27,20 @@ size_t TCPSegment::length_in_sequence_space() const {
     return payload().str().size() + (header().syn ? 1 : 0) + (header().fin ? 1 : 0);
 }
 
+//! \param[in] mss the largest payload of the returned segment
+TCPSegment TCPSegment::split_front(const size_t mss) {
+    TCPSegment front;
+    front._header = _header;
+    front._header.fin = false;
+    front._payload = _payload;
+    front._payload.remove_suffix(_payload.size() - min(mss, _payload.size()));
+
+    _header.seqno = _header.seqno + front.length_in_sequence_space();
+    _header.syn = false;
+    _payload.remove_prefix(front._payload.size());
+    return front;
+}
+
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
 BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
     TCPHeader header_out = _header;
@@ -31,6 +31,11 @@ class TCPSegment {
     //! \brief Segment's length in sequence space
     //! \note Equal to payload length plus one byte if SYN is set, plus one byte if FIN is set
     size_t length_in_sequence_space() const;
+
+    //! \brief Detach the first `mss` bytes of payload into a segment of their own
+    //! \details Used to split a large segment into wire-sized ones. The returned segment keeps
+    //! the SYN, this one keeps the FIN and advances its seqno; both share the payload Buffer.
+    TCPSegment split_front(const size_t mss);
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_SEGMENT_HH
@@ -5,11 +5,14 @@
 #include "tun.hh"
 #include "util.hh"
 
+#include <algorithm>
+#include <climits>
 #include <cstddef>
 #include <exception>
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
@@ -18,24 +21,66 @@
 
 using namespace std;
 
-static constexpr size_t TCP_TICK_MS = 10;
+//! most datagrams read in one go and handed to the TCPConnection as a burst
+static constexpr size_t MAX_READ_BURST = 32;
+
+//! most datagrams read in one wakeup, so that the ACKs of the bursts are not held back for long
+static constexpr size_t MAX_READ_PER_WAKEUP = 4 * MAX_READ_BURST;
 
 //! \param[in] condition is a function returning true if loop should continue
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
-    auto base_time = timestamp_ms();
     while (condition()) {
-        auto ret = _eventloop.wait_next_event(TCP_TICK_MS);
+        // datagrams left by a read that hit its cap may no longer be signaled by the fd, so read them
+        // here, and do not sleep while there are more
+        if (_datagrams_left and _tcp.value().active()) {
+            _read_datagrams();
+        }
+        auto ret = _eventloop.wait_next_event(_datagrams_left ? 0 : _wait_timeout());
         if (ret == EventLoop::Result::Exit or _abort) {
             break;
         }
 
-        if (_tcp.value().active()) {
-            const auto next_time = timestamp_ms();
-            _tcp.value().tick(next_time - base_time);
-            _datagram_adapter.tick(next_time - base_time);
-            base_time = next_time;
+        // fire the timers that came due while waiting
+        _tick();
+    }
+}
+
+template <typename AdaptT>
+int TCPSpongeSocket<AdaptT>::_wait_timeout() const {
+    optional<size_t> deadline = _tcp.value().ms_until_deadline();
+    if (const auto ms = _datagram_adapter.ms_until_deadline()) {
+        deadline = min(deadline.value_or(ms.value()), ms.value());
+    }
+    return deadline ? int(min<size_t>(deadline.value(), INT_MAX)) : -1;
+}
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_tick() {
+    const uint64_t now = timestamp_ms();
+    if (_tcp.value().active()) {
+        _tcp.value().tick(now - _last_tick);
+        _datagram_adapter.tick(now - _last_tick);
+    }
+    _last_tick = now;
+}
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_wake_up() {
+    const uint64_t one = 1;
+    SystemCall("write", ::write(_wakeup.fd_num(), &one, sizeof(one)));
+}
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_apply_cork() {
+    const bool corked = _corked.load();
+    if (corked != _tcp_corked and _tcp.value().active()) {
+        if (corked) {
+            _tcp.value().cork();
+        } else {
+            _tcp.value().uncork();
         }
+        _tcp_corked = corked;
     }
 }
 
@@ -46,17 +91,50 @@ TCPSpongeSocket<AdaptT>::TCPSpongeSocket(pair<FileDescriptor, FileDescriptor> da
                                          AdaptT &&datagram_interface)
     : LocalStreamSocket(move(data_socket_pair.first))
     , _thread_data(move(data_socket_pair.second))
-    , _datagram_adapter(move(datagram_interface)) {
+    , _datagram_adapter(move(datagram_interface))
+    , _wakeup(SystemCall("eventfd", ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))) {
     _thread_data.set_blocking(false);
 }
 
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_read_datagrams() {
+    // the segments must not be stamped with the time the loop went to sleep
+    _tick();
+
+    // read what has already arrived, so each burst gets one ACK
+    // NOTE: an adapter that reads in batches may hold datagrams the fd no longer signals
+    bool waiting = true;
+    size_t total = 0;
+    while (waiting and total < MAX_READ_PER_WAKEUP and _tcp->active()) {
+        vector<TCPSegment> segments;
+        do {
+            auto seg = _datagram_adapter.read();
+            ++total;
+            if (seg) {
+                segments.push_back(move(seg.value()));
+            }
+            waiting = _datagram_adapter.datagram_waiting();
+        } while (segments.size() < MAX_READ_BURST and waiting);
+        _tcp->segments_received(segments);
+    }
+    _datagrams_left = waiting and _tcp->active();
+
+    // debugging output:
+    if (_thread_data.eof() and _tcp.value().bytes_in_flight() == 0 and not _fully_acked) {
+        cerr << "DEBUG: Outbound stream to " << _datagram_adapter.config().destination.to_string()
+             << " has been fully acknowledged.\n";
+        _fully_acked = true;
+    }
+}
+
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     _tcp.emplace(config);
+    _last_tick = timestamp_ms();
 
     // Set up the event loop
 
-    // There are four possible events to handle:
+    // There are five possible events to handle:
     //
     // 1) Incoming datagram received (needs to be given to
     //    TCPConnection::segment_received method)
@@ -71,37 +149,23 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     //
     // 4) Outbound segment generated by TCP (needs to be
     //    given to underlying datagram socket)
+    //
+    // 5) A wakeup from the owner, after it has changed a flag
+    //    (e.g. corked or uncorked the connection)
 
     // rule 1: read from filtered packet stream and dump into TCPConnection
-    _eventloop.add_rule(_datagram_adapter,
-                        Direction::In,
-                        [&] {
-                            auto seg = _datagram_adapter.read();
-                            if (seg) {
-                                _tcp->segment_received(move(seg.value()));
-                            }
-
-                            // debugging output:
-                            if (_thread_data.eof() and _tcp.value().bytes_in_flight() == 0 and not _fully_acked) {
-                                cerr << "DEBUG: Outbound stream to "
-                                     << _datagram_adapter.config().destination.to_string()
-                                     << " has been fully acknowledged.\n";
-                                _fully_acked = true;
-                            }
-                        },
-                        [&] { return _tcp->active(); });
+    _eventloop.add_rule(
+        _datagram_adapter, Direction::In, [&] { _read_datagrams(); }, [&] { return _tcp->active(); });
 
     // rule 2: read from pipe into outbound buffer
     _eventloop.add_rule(
         _thread_data,
         Direction::In,
         [&] {
-            const auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
-            const auto len = data.size();
-            const auto amount_written = _tcp->write(move(data));
-            if (amount_written != len) {
-                throw runtime_error("TCPConnection::write() accepted less than advertised length");
-            }
+            // the owner may have corked before writing
+            _tick();
+            _apply_cork();
+            _tcp->write_from(_thread_data, _tcp->remaining_outbound_capacity());
 
             if (_thread_data.eof()) {
                 _tcp->end_input_stream();
@@ -129,8 +193,7 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
             // the pipe, handling the possibility of a partial
             // write (i.e., only pop what was actually written).
             const size_t amount_to_write = min(size_t(65536), inbound.buffer_size());
-            const std::string buffer = inbound.peek_output(amount_to_write);
-            const auto bytes_written = _thread_data.write(move(buffer), false);
+            const auto bytes_written = _thread_data.write(inbound.peek_views(amount_to_write), false);
             inbound.pop_output(bytes_written);
 
             if (inbound.eof() or inbound.error()) {
@@ -158,8 +221,20 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
                                 _datagram_adapter.write(_tcp->segments_out().front());
                                 _tcp->segments_out().pop();
                             }
+                            _datagram_adapter.flush();
                         },
                         [&] { return not _tcp->segments_out().empty(); });
+
+    // rule 5: apply the flags the owner has set
+    _eventloop.add_rule(
+        _wakeup,
+        Direction::In,
+        [&] {
+            _wakeup.read(sizeof(uint64_t));
+            _tick();
+            _apply_cork();
+        },
+        [&] { return _tcp->active(); });
 }
 
 //! \brief Call [socketpair](\ref man2::socketpair) and return connected Unix-domain sockets of specified type
@@ -183,6 +258,7 @@ TCPSpongeSocket<AdaptT>::~TCPSpongeSocket() {
             cerr << "Warning: unclean shutdown of TCPSpongeSocket\n";
             // force the other side to exit
             _abort.store(true);
+            _wake_up();
             _tcp_thread.join();
         }
     } catch (const exception &e) {
@@ -211,6 +287,7 @@ void TCPSpongeSocket<AdaptT>::connect(const TCPConfig &c_tcp, const FdAdapterCon
     _initialize_TCP(c_tcp);
 
     _datagram_adapter.config_mut() = c_ad;
+    _datagram_adapter.config_mut().mss = c_tcp.mss;
 
     cerr << "DEBUG: Connecting to " << c_ad.destination.to_string() << "... ";
     _tcp->connect();
@@ -239,6 +316,7 @@ void TCPSpongeSocket<AdaptT>::listen_and_accept(const TCPConfig &c_tcp, const Fd
     _initialize_TCP(c_tcp);
 
     _datagram_adapter.config_mut() = c_ad;
+    _datagram_adapter.config_mut().mss = c_tcp.mss;
     _datagram_adapter.set_listening(true);
 
     cerr << "DEBUG: Listening for incoming connection... ";
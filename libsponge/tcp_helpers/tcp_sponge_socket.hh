@@ -26,6 +26,9 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! Adapter to underlying datagram socket (e.g., UDP or IP)
     AdaptT _datagram_adapter;
 
+    //! [eventfd(2)](\ref man2::eventfd) that the owner writes to wake the TCPConnection thread up
+    FileDescriptor _wakeup;
+
     //! Set up the TCPConnection and the event loop
     void _initialize_TCP(const TCPConfig &config);
 
@@ -41,6 +44,22 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! Main loop of TCPConnection thread
     void _tcp_main();
 
+    //! Apply the owner's cork() or uncork() to the TCPConnection
+    void _apply_cork();
+
+    //! Advance the TCPConnection and the adapter to the current time
+    void _tick();
+
+    //! Wake the TCPConnection thread up, so that it sees a flag the owner has just set
+    void _wake_up();
+
+    //! How long the event loop may sleep: until the earliest deadline of the TCPConnection or the adapter,
+    //! or indefinitely (-1) when neither has one
+    int _wait_timeout() const;
+
+    //! Read bursts of datagrams (up to a cap) and give them to the TCPConnection
+    void _read_datagrams();
+
     //! Handle to the TCPConnection thread; owner thread calls join() in the destructor
     std::thread _tcp_thread{};
 
@@ -49,12 +68,20 @@ class TCPSpongeSocket : public LocalStreamSocket {
 
     std::atomic_bool _abort{false};  //!< Flag used by the owner to force the TCPConnection thread to shut down
 
+    std::atomic_bool _corked{false};  //!< Flag used by the owner to cork the TCPConnection
+
+    bool _tcp_corked{false};  //!< Has the TCPConnection thread applied the cork?
+
     bool _inbound_shutdown{false};  //!< Has TCPSpongeSocket shut down the incoming data to the owner?
 
     bool _outbound_shutdown{false};  //!< Has the owner shut down the outbound data to the TCP connection?
 
     bool _fully_acked{false};  //!< Has the outbound data been fully acknowledged by the peer?
 
+    bool _datagrams_left{false};  //!< Did the last read stop at its cap with datagrams still waiting?
+
+    uint64_t _last_tick{0};  //!< When the TCPConnection and the adapter were last ticked, in ms
+
   public:
     //! Construct from the interface that the TCPConnection thread will use to read and write datagrams
     explicit TCPSpongeSocket(AdaptT &&datagram_interface);
@@ -70,6 +97,19 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! Listen and accept using the specified configurations; blocks until accept succeeds or fails
     void listen_and_accept(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad);
 
+    //! Hold back written data until it fills a segment, like TCP_CORK
+    //! \note wakes the TCPConnection thread up to apply it
+    void cork() {
+        _corked.store(true);
+        _wake_up();
+    }
+
+    //! Send the data held back by cork()
+    void uncork() {
+        _corked.store(false);
+        _wake_up();
+    }
+
     //! When a connected socket is destructed, it will send a RST
     ~TCPSpongeSocket();
 
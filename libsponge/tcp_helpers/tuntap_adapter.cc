@@ -36,6 +36,21 @@ optional<TCPSegment> TCPOverIPv4OverEthernetAdapter::read() {
     return {};
 }
 
+optional<TCPSegment> TCPOverIPv4OverEthernetAdapter::read_any(FourTuple &tuple) {
+    EthernetFrame frame;
+    if (frame.parse(_tap.read()) != ParseResult::NoError) {
+        return {};
+    }
+
+    optional<InternetDatagram> ip_dgram = _interface.recv_frame(frame);
+    send_pending();
+
+    if (ip_dgram) {
+        return unwrap_tcp_in_ip(ip_dgram.value(), tuple);
+    }
+    return {};
+}
+
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPOverIPv4OverEthernetAdapter::tick(const size_t ms_since_last_tick) {
     _interface.tick(ms_since_last_tick);
@@ -44,10 +59,25 @@ void TCPOverIPv4OverEthernetAdapter::tick(const size_t ms_since_last_tick) {
 
 //! \param[in] seg the TCPSegment to send
 void TCPOverIPv4OverEthernetAdapter::write(TCPSegment &seg) {
+    while (seg.payload().size() > split_size()) {
+        TCPSegment front = seg.split_front(split_size());
+        _interface.send_datagram(wrap_tcp_in_ip(front), _next_hop);
+    }
     _interface.send_datagram(wrap_tcp_in_ip(seg), _next_hop);
     send_pending();
 }
 
+//! \param[in] tuple the connection the segment belongs to
+//! \param[in] seg the TCPSegment to send
+void TCPOverIPv4OverEthernetAdapter::write_to(const FourTuple &tuple, TCPSegment &seg) {
+    while (seg.payload().size() > split_size()) {
+        TCPSegment front = seg.split_front(split_size());
+        _interface.send_datagram(wrap_tcp_in_ip(tuple, front), _next_hop);
+    }
+    _interface.send_datagram(wrap_tcp_in_ip(tuple, seg), _next_hop);
+    send_pending();
+}
+
 void TCPOverIPv4OverEthernetAdapter::send_pending() {
     while (not _interface.frames_out().empty()) {
         _tap.write(_interface.frames_out().front().serialize());
@@ -1,11 +1,14 @@
 #ifndef SPONGE_LIBSPONGE_TUNFD_ADAPTER_HH
 #define SPONGE_LIBSPONGE_TUNFD_ADAPTER_HH
 
+#include "datagram_ring.hh"
 #include "ethernet_header.hh"
 #include "network_interface.hh"
 #include "tun.hh"
 
+#include <memory>
 #include <optional>
+#include <string>
 #include <unordered_map>
 #include <utility>
 
@@ -14,21 +17,79 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
   private:
     TunFD _tun;
 
+    //! Batches the reads and writes of `_tun`, once enable_io_uring() has been called
+    std::unique_ptr<DatagramRing> _ring{};
+
+    //! Read an IPv4 datagram (empty if none was waiting, with io_uring)
+    std::string _read() { return _ring ? _ring->read().value_or("") : _tun.read(); }
+
+    //! Write an IPv4 datagram, or prepare it to be written by flush() (with io_uring)
+    void _write(const BufferViewList &datagram) {
+        if (_ring) {
+            _ring->write(datagram);
+        } else {
+            _tun.write(datagram);
+        }
+    }
+
   public:
     //! Construct from a TunFD
     explicit TCPOverIPv4OverTunFdAdapter(TunFD &&tun) : _tun(std::move(tun)) {}
 
+    //! Read and write the TUN device through io_uring, up to `depth` datagrams per system call
+    //! \note makes the device non-blocking; writes are only sent by flush()
+    //! \returns `false` if io_uring is not available, and the device is then still read and written directly
+    bool enable_io_uring(const size_t depth = DatagramRing::DEFAULT_DEPTH) {
+        _ring = DatagramRing::make(_tun, false, depth);
+        return _ring != nullptr;
+    }
+
     //! Attempts to read and parse an IPv4 datagram containing a TCP segment related to the current connection
     std::optional<TCPSegment> read() {
         InternetDatagram ip_dgram;
-        if (ip_dgram.parse(_tun.read()) != ParseResult::NoError) {
+        if (ip_dgram.parse(_read()) != ParseResult::NoError) {
             return {};
         }
         return unwrap_tcp_in_ip(ip_dgram);
     }
 
-    //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
+    //! Creates IPv4 datagrams from a TCP segment (split at the MSS) and writes them to the TUN device
+    void write(TCPSegment &seg) {
+        while (seg.payload().size() > split_size()) {
+            TCPSegment front = seg.split_front(split_size());
+            _write(wrap_tcp_in_ip(front).serialize());
+        }
+        _write(wrap_tcp_in_ip(seg).serialize());
+    }
+
+    //! Attempts to read and parse an IPv4 datagram containing a TCP segment for any connection
+    std::optional<TCPSegment> read_any(FourTuple &tuple) {
+        InternetDatagram ip_dgram;
+        if (ip_dgram.parse(_read()) != ParseResult::NoError) {
+            return {};
+        }
+        return unwrap_tcp_in_ip(ip_dgram, tuple);
+    }
+
+    //! Creates IPv4 datagrams from a TCP segment of the connection identified by `tuple` and writes them
+    void write_to(const FourTuple &tuple, TCPSegment &seg) {
+        while (seg.payload().size() > split_size()) {
+            TCPSegment front = seg.split_front(split_size());
+            _write(wrap_tcp_in_ip(tuple, front).serialize());
+        }
+        _write(wrap_tcp_in_ip(tuple, seg).serialize());
+    }
+
+    //! Write the datagrams that write() and write_to() have prepared, with io_uring
+    void flush() {
+        if (_ring) {
+            _ring->flush();
+        }
+    }
+
+    //! \returns `true` if a datagram may be read without blocking
+    //! \note without io_uring, this costs a [poll(2)](\ref man2::poll), as the device is read blocking
+    bool datagram_waiting() const { return _ring ? _ring->datagram_waiting() : readable(_tun); }
 
     //! Access the underlying TUN device
     operator TunFD &() { return _tun; }
@@ -63,9 +124,22 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
     //! Sends a TCP segment (in an IPv4 datagram, in an Ethernet frame).
     void write(TCPSegment &seg);
 
+    //! Attempts to read a TCP segment for any connection, and the FourTuple it belongs to
+    std::optional<TCPSegment> read_any(FourTuple &tuple);
+
+    //! Sends a TCP segment of the connection identified by `tuple`
+    void write_to(const FourTuple &tuple, TCPSegment &seg);
+
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
+    //! \returns `true` if a frame may be read without blocking
+    //! \note this costs a [poll(2)](\ref man2::poll), as the device is read blocking
+    bool datagram_waiting() const { return readable(_tap); }
+
+    //! \returns ms until tick() next expires an ARP entry or request
+    std::optional<size_t> ms_until_deadline() const { return _interface.ms_until_deadline(); }
+
     //! Access the underlying raw Ethernet connection
     operator TapFD &() { return _tap; }
 
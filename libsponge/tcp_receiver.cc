@@ -6,12 +6,21 @@
 
 using namespace std;
 
-void TCPReceiver::segment_received(const TCPSegment &seg) {
+bool TCPReceiver::segment_received(const TCPSegment &seg) {
     if(_reassembler.stream_out().input_ended()){
-        return;
+        return true;
     }
 
-    const TCPHeader header = seg.header();
+    const TCPHeader &header = seg.header();
+
+    // PAWS: a segment with a timestamp older than TS.Recent is an old duplicate,
+    // possibly from before the sequence numbers wrapped
+    if(_hasSYN && header.timestamps.has_value() && _tsRecent.has_value() && !header.rst){
+        const uint32_t tsval = header.timestamps->first;
+        if(static_cast<int32_t>(tsval - _tsRecent.value()) < 0){
+            return false;
+        }
+    }
 
     if(!_hasSYN && header.syn) {
         _hasSYN = true;
@@ -22,13 +31,20 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
         _hasFIN = _hasFIN || header.fin;
 
         const uint64_t absIdx = unwrap(header.seqno, _isn, _reassembler.stream_out().bytes_written() + 1);
+        // remember the timestamp of a segment that starts at or before the ackno
+        if(header.timestamps.has_value() && absIdx <= _reassembler.stream_out().bytes_written() + 1){
+            _tsRecent = header.timestamps->first;
+        }
         // a segment with no syn flag and absIdx == 0 is invalid
         if(absIdx > 0 || header.syn){
             const uint64_t streamIdx = absIdx > 0 ? absIdx-1 : 0;
-            const string content = seg.payload().copy();
-            _reassembler.push_substring(content, streamIdx, header.fin);
+            if(streamIdx > _reassembler.stream_out().bytes_written() && seg.payload().size() > 0){
+                _lastOutOfOrder = streamIdx;
+            }
+            _reassembler.push_substring(seg.payload(), streamIdx, header.fin);
         }
     }
+    return true;
 }
 
 optional<WrappingInt32> TCPReceiver::ackno() const { 
@@ -43,3 +59,30 @@ optional<WrappingInt32> TCPReceiver::ackno() const {
 size_t TCPReceiver::window_size() const { 
     return _reassembler.stream_out().remaining_capacity(); 
 }
+
+vector<pair<WrappingInt32, WrappingInt32>> TCPReceiver::sack_blocks(const size_t max_blocks) const {
+    vector<pair<WrappingInt32, WrappingInt32>> blocks;
+    if(!_hasSYN || _reassembler.empty()){
+        return blocks;
+    }
+    // stream index i is sequence number i + 1 (after the SYN)
+    auto toBlock = [this](const pair<uint64_t, uint64_t> &range){
+        return make_pair(wrap(range.first + 1, _isn), wrap(range.second + 1, _isn));
+    };
+    const auto ranges = _reassembler.unassembled_ranges();
+    // the most recent block first, then the others from the highest down
+    for(const auto &range : ranges){
+        if(range.first <= _lastOutOfOrder && _lastOutOfOrder < range.second){
+            blocks.push_back(toBlock(range));
+        }
+    }
+    for(auto it = ranges.rbegin(); it != ranges.rend() && blocks.size() < max_blocks; ++it){
+        if(it->first > _lastOutOfOrder || _lastOutOfOrder >= it->second){
+            blocks.push_back(toBlock(*it));
+        }
+    }
+    if(blocks.size() > max_blocks){
+        blocks.erase(blocks.begin() + max_blocks, blocks.end());
+    }
+    return blocks;
+}
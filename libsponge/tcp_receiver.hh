@@ -7,6 +7,8 @@
 #include "wrapping_integers.hh"
 
 #include <optional>
+#include <utility>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -24,17 +26,27 @@ class TCPReceiver {
     bool _hasFIN;
     WrappingInt32 _isn;
 
+    // stream index of the most recently received segment that arrived out of order
+    uint64_t _lastOutOfOrder;
+
+    // the timestamp to echo to the peer (TS.Recent in RFC 7323)
+    std::optional<uint32_t> _tsRecent;
+
   public:
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
-    TCPReceiver(const size_t capacity) : 
-      _reassembler(capacity), 
+    //! \param storage how the reassembler stores out-of-order bytes
+    TCPReceiver(const size_t capacity,
+                const StreamReassembler::Storage storage = StreamReassembler::Storage::Segments) : 
+      _reassembler(capacity, storage), 
       _capacity(capacity),
       _hasSYN(false),
       _hasFIN(false),
-      _isn(0) {}
+      _isn(0),
+      _lastOutOfOrder(0),
+      _tsRecent() {}
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -57,13 +69,23 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief SACK blocks ([RFC 2018](\ref rfc::rfc2018)) for the out-of-order bytes held
+    //! \returns at most `max_blocks` blocks, the one holding the most recently received segment first
+    std::vector<std::pair<WrappingInt32, WrappingInt32>> sack_blocks(const size_t max_blocks) const;
+
+    //! \brief The timestamp to echo in the TSecr field ([RFC 7323](\ref rfc::rfc7323))
+    //! \returns empty if no segment with a timestamp has been received
+    std::optional<uint32_t> timestamp_echo() const { return _tsRecent; }
     //!@}
 
     //! \brief number of bytes stored but not yet reassembled
     size_t unassembled_bytes() const { return _reassembler.unassembled_bytes(); }
 
     //! \brief handle an inbound segment
-    void segment_received(const TCPSegment &seg);
+    //! \returns `false` if the segment was dropped as an old duplicate because its timestamp
+    //!          is older than the last one received (PAWS, [RFC 7323](\ref rfc::rfc7323))
+    bool segment_received(const TCPSegment &seg);
 
     //! \name "Output" interface for the reader
     //!@{
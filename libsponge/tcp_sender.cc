@@ -3,6 +3,10 @@
 
 #include <random>
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
 
 // For Lab 3, please replace with a real implementation that passes the
 // automated checks run by `make check_lab3`.
@@ -21,8 +25,12 @@ bool Timer::has_expired() const{
     return _current_time >= _current_rto;
 }
 
+size_t Timer::time_remaining() const{
+    return has_expired() ? 0 : _current_rto - _current_time;
+}
+
 void Timer::double_rto(){
-    _current_rto *= 2;
+    _current_rto = min(_current_rto * 2, _rto_max);
     _consecutive_doubles += 1;
 }
 
@@ -47,68 +55,271 @@ void Timer::set_back_off(bool can) {
     _back_off = can;
 }
 
+void Timer::set_bounds(const size_t rto_min, const size_t rto_max){
+    _rto_min = rto_min;
+    _rto_max = rto_max;
+    _init_rto = clamp(_init_rto, _rto_min, _rto_max);
+    _current_rto = clamp(_current_rto, _rto_min, _rto_max);
+}
+
+void Timer::sample_rtt(const size_t rtt){
+    // RFC 6298 2.2 and 2.3, with alpha = 1/8 and beta = 1/4
+    if(!_srtt.has_value()){
+        _srtt = rtt;
+        _rttvar = rtt / 2.0;
+    }
+    else{
+        _rttvar = 0.75 * _rttvar + 0.25 * abs(_srtt.value() - rtt);
+        _srtt = 0.875 * _srtt.value() + 0.125 * rtt;
+    }
+    // the clock granularity is 1 ms
+    const double rto = _srtt.value() + max(1.0, 4 * _rttvar);
+    _init_rto = clamp(size_t(ceil(rto)), _rto_min, _rto_max);
+}
+
+//! initial window of RFC 5681, bytes
+CongestionControl::CongestionControl(const size_t mss)
+    : _mss{mss}
+    , _cwnd{mss > 2190 ? 2 * mss : (mss > 1095 ? 3 * mss : 4 * mss)}
+    , _ssthresh{numeric_limits<size_t>::max()} {}
+
+unique_ptr<CongestionControl> CongestionControl::make(const TCPConfig::Congestion algorithm, const size_t mss) {
+    switch (algorithm) {
+        case TCPConfig::Congestion::Reno:
+            return make_unique<RenoCongestionControl>(mss);
+        case TCPConfig::Congestion::Cubic:
+            return make_unique<CubicCongestionControl>(mss);
+        default:
+            return nullptr;
+    }
+}
+
+void CongestionControl::on_partial_ack(const size_t acked){
+    _cwnd = max(_cwnd - min(acked, _cwnd), _mss) + _mss;
+}
+
+void CongestionControl::on_recovery_exit(const size_t in_flight){
+    _cwnd = min(_ssthresh, max(in_flight, _mss) + _mss);
+}
+
+void RenoCongestionControl::on_ack(const size_t acked, const uint64_t){
+    // slow start: grow by at most one mss per ack
+    if(in_slow_start()){
+        _cwnd += min(acked, _mss);
+        return;
+    }
+    // congestion avoidance: grow by one mss per window of acked bytes
+    _acked_bytes += acked;
+    if(_acked_bytes >= _cwnd){
+        _acked_bytes -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+void RenoCongestionControl::on_timeout(const size_t in_flight, const uint64_t){
+    _ssthresh = max(in_flight / 2, 2 * _mss);
+    _cwnd = _mss;
+    _acked_bytes = 0;
+}
+
+void RenoCongestionControl::on_fast_retransmit(const size_t in_flight, const uint64_t){
+    _ssthresh = max(in_flight / 2, 2 * _mss);
+    _cwnd = _ssthresh + 3 * _mss;
+    _acked_bytes = 0;
+}
+
+void CubicCongestionControl::on_ack(const size_t acked, const uint64_t now){
+    if(in_slow_start()){
+        _cwnd += min(acked, _mss);
+        return;
+    }
+    const double mss = _mss;
+    if(!_epoch_start.has_value()){
+        _epoch_start = now;
+        // no loss seen yet: grow from the current window
+        _w_max = max(_w_max, double(_cwnd));
+        _k = cbrt(max(_w_max - _cwnd, 0.0) / mss / C);
+        _w_est = _cwnd;
+    }
+    const double t = (now - _epoch_start.value()) / 1000.0;
+    const double target = _w_max + C * pow(t - _k, 3) * mss;
+
+    // the Reno-friendly estimate grows by alpha segments per window of acked bytes
+    const double alpha = 3 * (1 - BETA) / (1 + BETA);
+    _w_est += alpha * mss * acked / _cwnd;
 
+    if(_w_est > target){
+        _cwnd = max(_cwnd, size_t(_w_est));
+    }
+    else if(target > _cwnd){
+        // cover the distance to the target within one window of acks, at most 1.5x per window
+        const double increase = min(target - _cwnd, 0.5 * _cwnd) * acked / _cwnd;
+        _cwnd += max(size_t(increase), size_t(1));
+    }
+}
 
+void CubicCongestionControl::on_timeout(const size_t in_flight, const uint64_t){
+    _w_max = max(double(in_flight), double(_cwnd));
+    _ssthresh = max(size_t(in_flight * BETA), 2 * _mss);
+    _cwnd = _mss;
+    _epoch_start.reset();
+}
+
+void CubicCongestionControl::on_fast_retransmit(const size_t, const uint64_t){
+    _w_max = _cwnd;
+    _ssthresh = max(size_t(_cwnd * BETA), 2 * _mss);
+    _cwnd = _ssthresh + 3 * _mss;
+    _epoch_start.reset();
+}
 
 //! \param[in] capacity the capacity of the outgoing byte stream
 //! \param[in] retx_timeout the initial amount of time to wait before retransmitting the oldest outstanding segment
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
-TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
+//! \param[in] max_payload the largest payload of a segment (the MSS, or the super-segment size)
+TCPSender::TCPSender(const size_t capacity,
+                     const uint16_t retx_timeout,
+                     const std::optional<WrappingInt32> fixed_isn,
+                     const size_t max_payload)
     : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
     , _initial_retransmission_timeout{retx_timeout}
+    , _max_payload{max_payload}
+    , _mss{max_payload}
     , _stream(capacity) 
-    , _timer(retx_timeout){}
+    , _timer(retx_timeout)
+    , _congestion(nullptr){
+    if(max_payload == 0){
+        throw runtime_error("TCPSender: the max payload must be at least one byte");
+    }
+}
+
+//! \param[in] config supplies the capacity, timeout, ISN, payload size and congestion control
+TCPSender::TCPSender(const TCPConfig &config)
+    : TCPSender(config.send_capacity, config.rt_timeout, config.fixed_isn, max(config.mss, config.super_segment_size)) {
+    if(config.mss == 0){
+        throw runtime_error("TCPSender: TCPConfig::mss must be at least one byte");
+    }
+    _mss = config.mss;
+    _congestion = CongestionControl::make(config.congestion, config.mss);
+    _fast_retransmit = config.fast_retransmit;
+    _nagle = config.nagle;
+    _pacing = config.pacing;
+    _adaptive_rto = config.adaptive_rto;
+    if(_adaptive_rto){
+        _timer.set_bounds(config.rto_min, config.rto_max);
+    }
+}
+
+uint64_t TCPSender::_send_limit() const {
+    if(!_congestion){
+        return _can_send_seqno;
+    }
+    // always allow one byte in flight so the window can be probed
+    return min(_can_send_seqno, _ackno + max(_congestion->window(), size_t(1)) - 1);
+}
 
 uint64_t TCPSender::bytes_in_flight() const { 
     return _next_seqno - _ackno;
 }
 
+TCPSegment TCPSender::_make_segment(const FlyingSegment &flying) const {
+    TCPSegment seg;
+    seg.header().seqno = wrap(flying.seqno, _isn);
+    seg.header().syn = flying.syn;
+    seg.header().fin = flying.fin;
+    seg.payload() = flying.payload;
+    return seg;
+}
+
+void TCPSender::_send_segment(const bool syn, const bool fin, string &&payload) {
+    _flying_segments.push_back({_next_seqno, syn, fin, Buffer(std::move(payload)), _time, false, false});
+    _next_seqno = _flying_segments.back().end();
+    _segments_out.push(_make_segment(_flying_segments.back()));
+}
+
 void TCPSender::fill_window() {
     if(_next_seqno == 0){ // open TCP 
-        TCPSegment seg;
-        seg.header().seqno = wrap(_next_seqno, _isn);
-        seg.header().syn = true;
-        _segments_out.push(seg);
-        _flying_segments.push(seg);
-        _next_seqno += seg.length_in_sequence_space();
+        _send_segment(true, false);
     }
 
 
-    // fill new space as much as possible
-    while(_next_seqno <= _can_send_seqno && (!_stream.buffer_empty())){
-        TCPSegment seg;
-        seg.header().seqno = wrap(_next_seqno, _isn);
+    const uint64_t send_limit = _send_limit();
 
-        const size_t new_space = _can_send_seqno - _next_seqno + 1;
-        const size_t len = std::min(new_space, TCPConfig::MAX_PAYLOAD_SIZE);
-        seg.payload() = _stream.read(len);
+    // fill new space as much as possible, as fast as pacing allows;
+    // a zero-window probe is never paced, as nothing else would send it
+    const bool paced = _pacing_rate_per_ms().has_value() && _window_size > 0;
+    while(_next_seqno <= send_limit && (!_stream.buffer_empty()) && (!paced || _pacing_budget > 0)){
+        // less than a full MSS of data waits while corked, or with Nagle while data is in flight,
+        // unless the stream has ended; a super-segment then only carries whole MSS-sized segments
+        const size_t buffered = _stream.buffer_size();
+        const bool hold_short = !_stream.input_ended() && (_corked || (_nagle && bytes_in_flight() > 0));
+        if(hold_short && buffered < _mss){
+            break;
+        }
+        const size_t new_space = send_limit - _next_seqno + 1;
+        size_t len = std::min(new_space, _max_payload);
+        if(hold_short){
+            len = std::min(len, buffered - buffered % _mss);
+        }
+        string payload = _stream.read(len);
 
-        if(_stream.eof() && (_next_seqno + seg.length_in_sequence_space() <= _can_send_seqno)){
-            seg.header().fin = true;
+        const bool fin = _stream.eof() && (_next_seqno + payload.size() <= send_limit);
+        if(fin){
             _send_FIN = true;
         }
-
-        _next_seqno += seg.length_in_sequence_space();
-        _segments_out.push(seg);
-        _flying_segments.push(seg);
+        if(paced){
+            _pacing_budget -= payload.size();
+        }
+        _send_segment(false, fin, std::move(payload));
     }
     
     // reach eof but not send
-    if(!_send_FIN && _stream.eof() && _next_seqno <= _can_send_seqno){
-        TCPSegment seg;
-        seg.header().seqno = wrap(_next_seqno, _isn);
-        seg.header().fin = true;
-
-        _segments_out.push(seg);
-        _flying_segments.push(seg);
-        _next_seqno += seg.length_in_sequence_space();
+    if(!_send_FIN && _stream.eof() && _next_seqno <= send_limit){
+        _send_segment(false, true);
         _send_FIN = true;
     }
 }
 
+void TCPSender::_retransmit_front() {
+    _segments_out.push(_make_segment(_flying_segments.front()));
+    _flying_segments.front().retransmitted = true;
+}
+
+bool TCPSender::_retransmit_hole() {
+    const auto begins_before = [](const FlyingSegment &seg, const uint64_t seqno){ return seg.seqno < seqno; };
+    auto it = lower_bound(_flying_segments.begin(), _flying_segments.end(), _next_hole, begins_before);
+    for(; it != _flying_segments.end() && it->end() <= _highest_sacked; ++it){
+        if(!it->sacked && !it->retransmitted){
+            _segments_out.push(_make_segment(*it));
+            it->retransmitted = true;
+            _next_hole = it->end();
+            return true;
+        }
+    }
+    return false;
+}
+
+void TCPSender::sack_received(const vector<pair<WrappingInt32, WrappingInt32>> &blocks) {
+    const auto begins_before = [](const FlyingSegment &seg, const uint64_t seqno){ return seg.seqno < seqno; };
+    for(const auto &[left, right] : blocks){
+        const uint64_t start = unwrap(left, _isn, _next_seqno);
+        const uint64_t end = unwrap(right, _isn, _next_seqno);
+        // ignore blocks below the ackno (D-SACK) and impossible ones
+        if(start < _ackno || end > _next_seqno || start >= end){
+            continue;
+        }
+        _highest_sacked = max(_highest_sacked, end);
+        auto it = lower_bound(_flying_segments.begin(), _flying_segments.end(), start, begins_before);
+        for(; it != _flying_segments.end() && it->end() <= end; ++it){
+            it->sacked = true;
+        }
+    }
+}
+
 //! \param ackno The remote receiver's ackno (acknowledgment number)
-//! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) { 
+//! \param window_size The remote receiver's advertised window size, in bytes (already scaled)
+//! \param pure_ack whether the ack came in a segment that occupies no sequence space
+void TCPSender::ack_received(const WrappingInt32 ackno, const size_t window_size, const bool pure_ack) { 
+    const optional<uint32_t> timestamp_echo = exchange(_timestamp_echo, nullopt);
     const uint64_t new_ackno = unwrap(ackno, _isn, _next_seqno);
 
     // this is an old or impossible ack
@@ -116,8 +327,35 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
         return;
     }
 
+    // duplicate ack (RFC 5681): the third one triggers a fast retransmit, later ones inflate the window
+    const bool duplicate = _fast_retransmit && new_ackno == _ackno && pure_ack && window_size == _window_size &&
+                           !_flying_segments.empty();
+    if(duplicate){
+        _duplicate_acks += 1;
+        if(_recover.has_value()){
+            if(_congestion){
+                _congestion->on_duplicate_ack();
+            }
+            // with SACK, every duplicate ack may repair another hole instead of one per RTT
+            _retransmit_hole();
+        }
+        else if(_duplicate_acks == 3){
+            _recover = _next_seqno;
+            _retransmit_front();
+            _next_hole = _flying_segments.front().end();
+            if(_congestion){
+                _congestion->on_fast_retransmit(bytes_in_flight(), _time);
+            }
+        }
+    }
+    else if(new_ackno == _ackno){
+        _duplicate_acks = 0;
+    }
+
     // update timer
+    const size_t acked = new_ackno - _ackno;
     if(new_ackno > _ackno){
+        _duplicate_acks = 0;
         _timer.reset_time();
         _timer.reset_rto();
         _timer.set_back_off(window_size > 0 ? true : false);
@@ -125,31 +363,83 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
 
     // update ackno and new_space
     _ackno = new_ackno;
+    _window_size = window_size;
     _can_send_seqno = max(max(_ackno + window_size - 1, _ackno), _can_send_seqno);
 
     
-    // remove acked segments from flying set
-    while (! _flying_segments.empty()){
-        const TCPSegment oldest = _flying_segments.front();
-        const size_t last_byte = unwrap(oldest.header().seqno, _isn, _ackno) + oldest.length_in_sequence_space() - 1;
+    // remove acked segments from flying set, the newest one gives an RTT sample
+    // unless the ack also covers retransmitted data (Karn's rule); a timestamp echo
+    // tells which transmission was acked, so it gives a sample in any case
+    optional<uint64_t> sent_at{};
+    bool retransmitted = false;
+    while (!_flying_segments.empty() && _flying_segments.front().end() <= _ackno){
+        sent_at = _flying_segments.front().sent_at;
+        retransmitted |= _flying_segments.front().retransmitted;
+        _flying_segments.pop_front();
+    }
+    if(_adaptive_rto && acked > 0 && timestamp_echo.has_value()){
+        _timer.sample_rtt(static_cast<uint32_t>(timestamp() - timestamp_echo.value()));
+        _timer.reset_rto();
+    }
+    else if(_adaptive_rto && sent_at.has_value() && !retransmitted){
+        _timer.sample_rtt(_time - sent_at.value());
+        _timer.reset_rto();
+    }
 
-        if (last_byte < _ackno){
-            _flying_segments.pop();
+    if(acked > 0 && _recover.has_value()){
+        // NewReno (RFC 6582): a partial ack means the next segment was lost too
+        if(_ackno < _recover.value()){
+            // the front may already have been retransmitted as a SACK hole
+            if(!_flying_segments.front().retransmitted){
+                _retransmit_front();
+            }
+            else{
+                _next_hole = max(_next_hole, _ackno);
+                _retransmit_hole();
+            }
+            if(_congestion){
+                _congestion->on_partial_ack(acked);
+            }
         }
         else{
-            break;
+            _recover.reset();
+            if(_congestion){
+                _congestion->on_recovery_exit(bytes_in_flight());
+            }
         }
     }
+    // the SYN does not count as acked data
+    else if(acked > 0 && _congestion && _ackno > 1){
+        _congestion->on_ack(_ackno - max(_ackno - acked, uint64_t(1)), _time);
+    }
     fill_window();
 }
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPSender::tick(const size_t ms_since_last_tick) { 
+    _time += ms_since_last_tick;
+
+    // pacing lets more bytes go; an idle sender saves up no more than two segments,
+    // a busy one no more than this tick's share
+    const optional<double> rate = _pacing_rate_per_ms();
+    if(rate.has_value()){
+        const double credit = rate.value() * ms_since_last_tick;
+        const double quantum = _stream.buffer_empty() ? 2.0 * _max_payload : max(credit, 2.0 * _max_payload);
+        _pacing_budget = min(_pacing_budget + credit, quantum);
+        fill_window();
+    }
+
     _timer.increment(ms_since_last_tick);
     if(_timer.has_expired()){
         if(!_flying_segments.empty()){
-            _segments_out.push(_flying_segments.front());
+            _retransmit_front();
+            // a timeout ends fast recovery
+            _recover.reset();
+            _duplicate_acks = 0;
             if(_timer.can_back_off()){
+                if(_congestion){
+                    _congestion->on_timeout(bytes_in_flight(), _time);
+                }
                 _timer.double_rto();
             }
         }
@@ -157,13 +447,57 @@ void TCPSender::tick(const size_t ms_since_last_tick) {
     }
 }
 
+optional<size_t> TCPSender::ms_until_deadline() const {
+    optional<size_t> deadline{};
+    if(!_flying_segments.empty()){
+        deadline = _timer.time_remaining();
+    }
+
+    // pacing holds back data that the window would let go
+    const optional<double> rate = _pacing_rate_per_ms();
+    if(rate.has_value() && rate.value() > 0 && _pacing_budget <= 0 && !_stream.buffer_empty()
+       && _next_seqno <= _send_limit()){
+        const size_t refill = static_cast<size_t>(-_pacing_budget / rate.value()) + 1;
+        deadline = min(deadline.value_or(refill), refill);
+    }
+    return deadline;
+}
+
+//! Like Linux: twice the window per RTT in slow start, 1.2 times in congestion avoidance,
+//! but at least one segment per RTT
+optional<double> TCPSender::_pacing_rate_per_ms() const {
+    const optional<double> srtt = _timer.smoothed_rtt();
+    if(!_pacing || !srtt.has_value()){
+        return {};
+    }
+    const bool slow_start = _congestion && _congestion->in_slow_start();
+    const double window = _congestion ? _congestion->window() : _window_size;
+    return max((slow_start ? 2.0 : 1.2) * window, double(_max_payload)) / max(srtt.value(), 1.0);
+}
+
+optional<uint64_t> TCPSender::pacing_rate() const {
+    const optional<double> rate = _pacing_rate_per_ms();
+    if(!rate.has_value()){
+        return {};
+    }
+    return static_cast<uint64_t>(rate.value() * 1000);
+}
+
 unsigned int TCPSender::consecutive_retransmissions() const { 
     return _timer.consecutive_doubles(); 
 }
 
+size_t TCPSender::congestion_window() const {
+    return _congestion ? _congestion->window() : numeric_limits<size_t>::max();
+}
+
+size_t TCPSender::slow_start_threshold() const {
+    return _congestion ? _congestion->slow_start_threshold() : numeric_limits<size_t>::max();
+}
+
 void TCPSender::send_empty_segment() {
     TCPSegment seg;
     seg.header().seqno = wrap(_next_seqno, _isn);
     //seg.header().ack = true;
-    _segments_out.push(seg);
+    _segments_out.push(std::move(seg));
 }
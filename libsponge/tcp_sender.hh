@@ -6,28 +6,132 @@
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
+#include <deque>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <queue>
 #include <set>
+#include <utility>
+#include <vector>
 
 class Timer {
   private:
-    const size_t _init_rto;
+    // rto without back off: the initial value until an RTT has been sampled
+    size_t _init_rto;
     bool _back_off{true};
     size_t _current_rto;
     size_t _current_time{0};
     size_t _consecutive_doubles{0};
 
+    // bounds of the rto
+    size_t _rto_min{0};
+    size_t _rto_max{std::numeric_limits<size_t>::max()};
+
+    // RTT estimates of RFC 6298, in ms
+    std::optional<double> _srtt{};
+    double _rttvar{0};
+
   public:
     Timer(const size_t rto);
     void increment(const size_t ms);
     size_t consecutive_doubles() const;
     bool has_expired() const;
+    //! ms until has_expired() becomes true
+    size_t time_remaining() const;
     bool can_back_off() const;
     void reset_time();
     void reset_rto();
     void double_rto();
     void set_back_off(bool can);
+
+    //! clamp the rto (including back off) to [rto_min, rto_max]
+    void set_bounds(const size_t rto_min, const size_t rto_max);
+    //! update SRTT and RTTVAR with a measured RTT and recompute the rto
+    void sample_rtt(const size_t rtt);
+
+    size_t rto() const { return _current_rto; }
+    std::optional<double> smoothed_rtt() const { return _srtt; }
+    double rtt_variation() const { return _rttvar; }
+};
+
+//! \brief Congestion control algorithm of a TCPSender
+//! \details Keeps the congestion window (cwnd) and slow start threshold (ssthresh), in bytes.
+//! The sender never has more than cwnd bytes in flight.
+class CongestionControl {
+  protected:
+    const size_t _mss;
+    size_t _cwnd;
+    size_t _ssthresh;
+
+  public:
+    CongestionControl(const size_t mss);
+    virtual ~CongestionControl() = default;
+
+    //! \brief create the algorithm chosen in TCPConfig, or nullptr for TCPConfig::Congestion::None
+    static std::unique_ptr<CongestionControl> make(const TCPConfig::Congestion algorithm, const size_t mss);
+
+    size_t window() const { return _cwnd; }
+    size_t slow_start_threshold() const { return _ssthresh; }
+    bool in_slow_start() const { return _cwnd < _ssthresh; }
+
+    //! \brief `acked` new bytes were acknowledged at time `now` (in ms)
+    virtual void on_ack(const size_t acked, const uint64_t now) = 0;
+
+    //! \brief the retransmission timer expired with `in_flight` bytes outstanding
+    virtual void on_timeout(const size_t in_flight, const uint64_t now) = 0;
+
+    //! \brief three duplicate acks triggered a fast retransmit: reduce ssthresh and enter fast recovery
+    virtual void on_fast_retransmit(const size_t in_flight, const uint64_t now) = 0;
+
+    //! \name NewReno fast recovery (RFC 6582), shared by all algorithms
+    //!@{
+
+    //! \brief a further duplicate ack inflates cwnd by one segment
+    void on_duplicate_ack() { _cwnd += _mss; }
+
+    //! \brief a partial ack deflates cwnd by the `acked` bytes, then adds back one segment
+    void on_partial_ack(const size_t acked);
+
+    //! \brief the recovery point was acked: deflate cwnd to ssthresh
+    void on_recovery_exit(const size_t in_flight);
+    //!@}
+};
+
+//! \brief Slow start and congestion avoidance as in RFC 5681
+class RenoCongestionControl : public CongestionControl {
+  private:
+    // bytes acked since cwnd last grew in congestion avoidance
+    size_t _acked_bytes{0};
+
+  public:
+    using CongestionControl::CongestionControl;
+    void on_ack(const size_t acked, const uint64_t now) override;
+    void on_timeout(const size_t in_flight, const uint64_t now) override;
+    void on_fast_retransmit(const size_t in_flight, const uint64_t now) override;
+};
+
+//! \brief CUBIC window growth as in RFC 9438
+class CubicCongestionControl : public CongestionControl {
+  private:
+    static constexpr double C = 0.4;
+    static constexpr double BETA = 0.7;
+
+    // cwnd just before the last reduction, in bytes
+    double _w_max{0};
+    // start of the current congestion avoidance epoch, in ms
+    std::optional<uint64_t> _epoch_start{};
+    // time for the cubic function to reach _w_max, in seconds
+    double _k{0};
+    // window a Reno flow would have, in bytes
+    double _w_est{0};
+
+  public:
+    using CongestionControl::CongestionControl;
+    void on_ack(const size_t acked, const uint64_t now) override;
+    void on_timeout(const size_t in_flight, const uint64_t now) override;
+    void on_fast_retransmit(const size_t in_flight, const uint64_t now) override;
 };
 
 /**
@@ -51,12 +155,35 @@ class TCPSender {
     //! outbound queue of segments that the TCPSender wants sent
     std::queue<TCPSegment> _segments_out{};
 
-    //! segments that be sent but not be acked
-    std::queue<TCPSegment> _flying_segments{};
+    //! a segment that has been sent but not acked, kept by absolute seqno so
+    //! that acks never need to unwrap it; the payload shares the sent segment's Buffer
+    struct FlyingSegment {
+        uint64_t seqno;
+        bool syn;
+        bool fin;
+        Buffer payload;
+        //! when the segment was first sent, in ms
+        uint64_t sent_at;
+        //! retransmitted segments give no RTT sample (Karn's rule)
+        bool retransmitted;
+        //! the receiver holds the segment out of order (SACK scoreboard)
+        bool sacked;
+
+        uint64_t end() const { return seqno + syn + payload.size() + fin; }
+    };
+
+    //! segments that be sent but not be acked, ordered by seqno
+    std::deque<FlyingSegment> _flying_segments{};
 
     //! retransmission timer for the connection
     unsigned int _initial_retransmission_timeout;
 
+    //! the largest payload of a segment created by fill_window
+    size_t _max_payload;
+
+    //! the MSS, which Nagle's algorithm and corking count full segments in
+    size_t _mss;
+
     //! outgoing stream of bytes that have not yet been sent
     ByteStream _stream;
 
@@ -74,11 +201,76 @@ class TCPSender {
 
     Timer _timer;
 
+    //! congestion control, or nullptr if only the receive window limits the sender
+    std::unique_ptr<CongestionControl> _congestion;
+
+    //! milliseconds passed since the sender was created
+    uint64_t _time{0};
+
+    //! whether acks update the RTT estimates and the rto
+    bool _adaptive_rto{false};
+
+    //! whether three duplicate acks trigger a fast retransmit
+    bool _fast_retransmit{false};
+
+    //! whether segments smaller than the max payload wait until nothing is in flight (Nagle's algorithm)
+    bool _nagle{false};
+
+    //! whether segments smaller than the max payload wait until uncorked
+    bool _corked{false};
+
+    //! whether new segments are paced
+    bool _pacing{false};
+
+    //! bytes that pacing lets go before the next tick; may go negative by up to one segment
+    double _pacing_budget{0};
+
+    //! pacing rate in bytes per ms, or empty if segments are not paced (yet)
+    std::optional<double> _pacing_rate_per_ms() const;
+
+    //! the last window size advertised by the receiver
+    size_t _window_size{0};
+
+    //! number of duplicate acks received in a row
+    unsigned int _duplicate_acks{0};
+
+    //! while in fast recovery, the (absolute) next seqno at the time it was entered
+    std::optional<uint64_t> _recover{};
+
+    //! the (absolute) end of the highest SACK block received
+    uint64_t _highest_sacked{0};
+
+    //! in fast recovery, the (absolute) seqno from which to look for the next hole to retransmit
+    uint64_t _next_hole{0};
+
+    //! TSecr of the segment whose ack is about to be processed
+    std::optional<uint32_t> _timestamp_echo{};
+
+    //! retransmit the oldest outstanding segment
+    void _retransmit_front();
+
+    //! retransmit the first segment below the highest SACK block that is neither sacked nor retransmitted
+    //! \returns whether a segment was retransmitted
+    bool _retransmit_hole();
+
+    //! the (absolute) seqence number of the farest byte that both windows allow to be sent
+    uint64_t _send_limit() const;
+
+    //! build the TCPSegment for a flying segment
+    TCPSegment _make_segment(const FlyingSegment &flying) const;
+
+    //! send a new segment and keep it until it is acked
+    void _send_segment(const bool syn, const bool fin, std::string &&payload = {});
+
   public:
     //! Initialize a TCPSender
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
-              const std::optional<WrappingInt32> fixed_isn = {});
+              const std::optional<WrappingInt32> fixed_isn = {},
+              const size_t max_payload = TCPConfig::MAX_PAYLOAD_SIZE);
+
+    //! Initialize a TCPSender from the sender fields of a TCPConfig
+    explicit TCPSender(const TCPConfig &config);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -90,7 +282,16 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \note only acks in segments without data (`pure_ack`) count as duplicate acks
+    void ack_received(const WrappingInt32 ackno, const size_t window_size, const bool pure_ack = true);
+
+    //! \brief SACK blocks were received, call before ack_received() for the same segment
+    //! \details marks the outstanding segments held by the receiver, so fast recovery retransmits only the holes
+    void sack_received(const std::vector<std::pair<WrappingInt32, WrappingInt32>> &blocks);
+
+    //! \brief A timestamp echo (TSecr) was received, call before ack_received() for the same segment
+    //! \details if the ack covers new data, the echo gives the RTT sample even for retransmitted data
+    void timestamp_echo_received(const uint32_t tsecr) { _timestamp_echo = tsecr; }
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
@@ -100,6 +301,15 @@ class TCPSender {
 
     //! \brief Notifies the TCPSender of the passage of time
     void tick(const size_t ms_since_last_tick);
+
+    //! \brief ms until tick() has something to do: the retransmission timer expires, or pacing
+    //! lets held-back data go
+    //! \returns an empty value if no timer is running
+    std::optional<size_t> ms_until_deadline() const;
+
+    //! \brief Hold back (or stop holding back) data that does not fill a segment
+    //! \note uncorking does not send by itself, call fill_window() afterwards
+    void set_corked(const bool corked) { _corked = corked; }
     //!@}
 
     //! \name Accessors
@@ -113,6 +323,34 @@ class TCPSender {
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief Congestion window in bytes (SIZE_MAX without congestion control)
+    size_t congestion_window() const;
+
+    //! \brief Slow start threshold in bytes (SIZE_MAX without congestion control)
+    size_t slow_start_threshold() const;
+
+    //! \brief Current retransmission timeout in ms, including back off
+    size_t retransmission_timeout() const { return _timer.rto(); }
+
+    //! \brief Smoothed RTT in ms, if any RTT has been measured (only with TCPConfig::adaptive_rto)
+    std::optional<double> smoothed_rtt() const { return _timer.smoothed_rtt(); }
+
+    //! \brief RTT variation in ms
+    double rtt_variation() const { return _timer.rtt_variation(); }
+
+    //! \brief Pacing rate in bytes per second
+    //! \returns empty if pacing is off or no RTT has been measured yet
+    std::optional<uint64_t> pacing_rate() const;
+
+    //! \brief Whether data that does not fill a segment is held back
+    bool corked() const { return _corked; }
+
+    //! \brief Whether the sender is in fast recovery
+    bool in_fast_recovery() const { return _recover.has_value(); }
+
+    //! \brief The value for the TSval field of outgoing segments: the sender's clock in ms
+    uint32_t timestamp() const { return static_cast<uint32_t>(_time); }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
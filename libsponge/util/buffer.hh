@@ -13,14 +13,26 @@
 //! \brief A reference-counted read-only string that can discard bytes from the front
 class Buffer {
   private:
-    std::shared_ptr<std::string> _storage{};
+    std::shared_ptr<const char> _storage{};
+    size_t _storage_size{};
     size_t _starting_offset{};
+    size_t _ending_offset{};
 
   public:
     Buffer() = default;
 
     //! \brief Construct by taking ownership of a string
-    Buffer(std::string &&str) noexcept : _storage(std::make_shared<std::string>(std::move(str))) {}
+    Buffer(std::string &&str) noexcept {
+        const auto owner = std::make_shared<std::string>(std::move(str));
+        _storage = std::shared_ptr<const char>(owner, owner->data());
+        _storage_size = owner->size();
+    }
+
+    //! \brief Construct by taking ownership of a heap array of `size` bytes (which need not be initialized first)
+    Buffer(std::unique_ptr<char[]> &&data, const size_t size) : _storage_size(size) {
+        const std::shared_ptr<char[]> owner = std::move(data);
+        _storage = std::shared_ptr<const char>(owner, owner.get());
+    }
 
     //! \name Expose contents as a std::string_view
     //!@{
@@ -28,7 +40,7 @@ class Buffer {
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage.get() + _starting_offset, _storage_size - _starting_offset - _ending_offset};
     }
 
     operator std::string_view() const { return str(); }
@@ -40,12 +52,19 @@ class Buffer {
     //! \brief Size of the string
     size_t size() const { return str().size(); }
 
+    //! \brief Size of the storage the string is a view of (which stays allocated while the view exists)
+    size_t storage_size() const { return _storage ? _storage_size : 0; }
+
     //! \brief Make a copy to a new std::string
     std::string copy() const { return std::string(str()); }
 
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief Discard the last `n` bytes of the string (does not require a copy or move)
+    //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
+    void remove_suffix(const size_t n);
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
@@ -101,6 +120,8 @@ class BufferViewList {
     //! \name Constructors
     //!@{
 
+    BufferViewList() = default;
+
     //! \brief Construct from a std::string
     BufferViewList(const std::string &str) : BufferViewList(std::string_view(str)) {}
 
@@ -114,6 +135,13 @@ class BufferViewList {
     BufferViewList(std::string_view str) { _views.push_back({const_cast<char *>(str.data()), str.size()}); }
     //!@}
 
+    //! \brief Append a view to the end of the list (empty views are skipped)
+    void append(const std::string_view str) {
+        if (not str.empty()) {
+            _views.push_back(str);
+        }
+    }
+
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     void remove_prefix(size_t n);
 
@@ -0,0 +1,176 @@
+#include "datagram_ring.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+//! fewest reads submitted in one batch
+static constexpr size_t MIN_BATCH = 4;
+
+//! \returns `depth`, which must be at least 1 (an empty batch would always look full)
+static size_t checked_depth(const size_t depth) {
+    if (depth == 0) {
+        throw runtime_error("DatagramRing: depth must be at least 1");
+    }
+    return depth;
+}
+
+//! \param[in] fd is the socket or device; it is made non-blocking
+//! \param[in] addressed is `true` to read and write with recvmsg/sendmsg (for a datagram socket),
+//!                      `false` to read and write the registered buffers directly (e.g. for a TUN device)
+//! \param[in] depth is the most datagrams read, or written, per batch (at least 1)
+DatagramRing::DatagramRing(const FileDescriptor &fd, const bool addressed, const size_t depth)
+    : _fd(fd.duplicate())
+    , _addressed(addressed)
+    , _depth(checked_depth(depth))
+    , _ring(2 * _depth, 2 * _depth, MAX_DATAGRAM)
+    , _slots(2 * depth)
+    , _batch(min(MIN_BATCH, depth)) {
+    _fd.set_blocking(false);
+    for (size_t i = 0; i < _slots.size(); ++i) {
+        Slot &slot = _slots[i];
+        slot.payload = {_ring.buffer(i), MAX_DATAGRAM};
+        slot.message.msg_name = &slot.address;
+        slot.message.msg_namelen = sizeof(slot.address);
+        slot.message.msg_iov = &slot.payload;
+        slot.message.msg_iovlen = 1;
+        (i < _depth ? _free_read : _free_write).push_back(i);
+    }
+}
+
+//! \param[in] fd is the socket or device; it is made non-blocking, unless nullptr is returned
+//! \param[in] addressed is as for the constructor
+//! \param[in] depth is as for the constructor
+unique_ptr<DatagramRing> DatagramRing::make(const FileDescriptor &fd, const bool addressed, const size_t depth) {
+    try {
+        return make_unique<DatagramRing>(fd, addressed, depth);
+    } catch (const unix_error &e) {
+        if (e.code().value() == ENOSYS or e.code().value() == EPERM) {
+            return nullptr;
+        }
+        throw;
+    }
+}
+
+void DatagramRing::_reap() {
+    while (const auto completion = _ring.reap()) {
+        const size_t index = completion->user_data;
+        const int32_t result = completion->result;
+        if (index >= _depth) {
+            // a full send buffer drops the datagram, as the network might
+            if (result < 0 and result != -EAGAIN and result != -ENOBUFS) {
+                throw unix_error(_addressed ? "sendmsg" : "write", -result);
+            }
+            _free_write.push_back(index);
+            continue;
+        }
+
+        _reads_in_flight--;
+        if (result < 0 and result != -EAGAIN) {
+            throw unix_error(_addressed ? "recvmsg" : "read", -result);
+        }
+        if (result > 0 and size_t(result) <= MAX_DATAGRAM) {
+            _slots[index].length = result;
+            _received.push_back(index);
+        } else {
+            _free_read.push_back(index);
+        }
+    }
+}
+
+void DatagramRing::_read_batch() {
+    const size_t n_reads = min(_batch, _free_read.size());
+    for (size_t i = 0; i < n_reads; ++i) {
+        const size_t index = _free_read.back();
+        _free_read.pop_back();
+        if (_addressed) {
+            _slots[index].message.msg_namelen = sizeof(sockaddr_storage);
+            _ring.recvmsg(_fd, _slots[index].message, index);
+        } else {
+            _ring.read_fixed(_fd, index, index);
+        }
+        _reads_in_flight++;
+    }
+
+    // the reads complete straight away, as the fd is non-blocking
+    _ring.submit(n_reads);
+    _reap();
+    while (_reads_in_flight > 0) {
+        _ring.submit(1);
+        _reap();
+    }
+
+    _batch_filled = _received.size() == n_reads;
+    _batch = clamp(2 * _received.size(), min(MIN_BATCH, _depth), _depth);
+}
+
+//! \param[out] source is set to the address the datagram came from, if not `nullptr`
+//! \returns the payload, or an empty value if no datagram was waiting
+optional<string> DatagramRing::read(Address *source) {
+    _fd.register_read();
+    if (_received.empty()) {
+        _read_batch();
+    }
+    if (_received.empty()) {
+        return {};
+    }
+
+    const size_t index = _received.front();
+    _received.pop_front();
+    const Slot &slot = _slots[index];
+    string payload(static_cast<const char *>(slot.payload.iov_base), slot.length);
+    if (source) {
+        *source = Address(reinterpret_cast<const sockaddr *>(&slot.address), slot.message.msg_namelen);
+    }
+    _free_read.push_back(index);
+    return payload;
+}
+
+//! \param[in] payload is the datagram to write
+//! \param[in] destination is the address to send it to; required for an addressed fd
+void DatagramRing::write(const BufferViewList &payload, const Address *destination) {
+    if (payload.size() > MAX_DATAGRAM) {
+        throw runtime_error("DatagramRing: datagram payload too big");
+    }
+    if (_addressed and destination == nullptr) {
+        throw runtime_error("DatagramRing: datagram without a destination");
+    }
+
+    // wait for an earlier write to finish with its buffer
+    if (_free_write.empty()) {
+        flush();
+    }
+    while (_free_write.empty()) {
+        _ring.submit(1);
+        _reap();
+    }
+
+    _fd.register_write();
+    const size_t index = _free_write.back();
+    _free_write.pop_back();
+    Slot &slot = _slots[index];
+    slot.length = 0;
+    for (const iovec &piece : payload.as_iovecs()) {
+        memcpy(static_cast<char *>(slot.payload.iov_base) + slot.length, piece.iov_base, piece.iov_len);
+        slot.length += piece.iov_len;
+    }
+
+    if (_addressed) {
+        memcpy(&slot.address, static_cast<const sockaddr *>(*destination), destination->size());
+        slot.message.msg_namelen = destination->size();
+        slot.payload.iov_len = slot.length;
+        _ring.sendmsg(_fd, slot.message, index);
+    } else {
+        _ring.write_fixed(_fd, index, slot.length, index);
+    }
+}
+
+void DatagramRing::flush() {
+    _ring.submit();
+    _reap();
+}
@@ -0,0 +1,101 @@
+#ifndef SPONGE_LIBSPONGE_DATAGRAM_RING_HH
+#define SPONGE_LIBSPONGE_DATAGRAM_RING_HH
+
+#include "address.hh"
+#include "buffer.hh"
+#include "file_descriptor.hh"
+#include "io_uring.hh"
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <sys/socket.h>
+#include <utility>
+#include <vector>
+
+//! Reads and writes the datagrams (or packets) of a non-blocking FileDescriptor in batches, through an IoUring
+class DatagramRing {
+  public:
+    //! Default number of datagrams read, and written, per batch
+    static constexpr size_t DEFAULT_DEPTH = 64;
+
+    //! Largest datagram that can be read or written
+    static constexpr size_t MAX_DATAGRAM = 4096;
+
+  private:
+    //! A registered buffer, and the message that reads or writes it
+    struct Slot {
+        iovec payload{};             //!< The buffer
+        sockaddr_storage address{};  //!< The source or destination of the datagram
+        msghdr message{};            //!< recvmsg() or sendmsg() arguments that point at the above
+        size_t length{0};            //!< Length of the datagram in the buffer
+    };
+
+    //! A FileDescriptor whose reads and writes (which EventLoop counts) are made through the ring
+    class RingFD : public FileDescriptor {
+      public:
+        //! Take over `fd`
+        explicit RingFD(FileDescriptor &&fd) : FileDescriptor(std::move(fd)) {}
+
+        using FileDescriptor::register_read;
+        using FileDescriptor::register_write;
+    };
+
+    RingFD _fd;       //!< The socket or device
+    bool _addressed;  //!< Is `_fd` a socket whose datagrams have addresses (or, e.g., a TUN device)?
+    size_t _depth;    //!< Number of slots for reading, and of slots for writing
+
+    IoUring _ring;                      //!< The io_uring
+    std::vector<Slot> _slots;           //!< Slots [0, _depth) read datagrams, and [_depth, 2 * _depth) write them
+    std::deque<size_t> _received{};     //!< Reading slots that hold a datagram, oldest first
+    std::vector<size_t> _free_read{};   //!< Reading slots that are not in use
+    std::vector<size_t> _free_write{};  //!< Writing slots that are not in use
+    size_t _reads_in_flight{0};         //!< Reads submitted and not yet completed
+    size_t _batch;                      //!< Number of reads the next batch submits
+    bool _batch_filled{false};          //!< Did the last batch read as many datagrams as it asked for?
+
+    //! Submit a batch of reads (along with any writes prepared), and wait for them to complete
+    void _read_batch();
+
+    //! Handle the completions that have been posted
+    void _reap();
+
+  public:
+    //! Batch the I/O of `fd`, which is made non-blocking; `addressed` is true for a datagram socket
+    DatagramRing(const FileDescriptor &fd, const bool addressed, const size_t depth = DEFAULT_DEPTH);
+
+    //! \returns a DatagramRing for `fd`, or nullptr if the kernel refuses to set up an io_uring
+    //! (e.g. it lacks io_uring, disables it with kernel.io_uring_disabled, or a seccomp filter blocks it)
+    static std::unique_ptr<DatagramRing> make(const FileDescriptor &fd,
+                                              const bool addressed,
+                                              const size_t depth = DEFAULT_DEPTH);
+
+    //! \returns the payload of the next datagram, reading a batch of them if none is left from the last one
+    //! \param[out] source is set to the source of the datagram (for an addressed fd)
+    std::optional<std::string> read(Address *source = nullptr);
+
+    //! Prepare a write of one datagram; it is sent by the next flush() (or read)
+    //! \param[in] destination is where to send the datagram (for an addressed fd)
+    void write(const BufferViewList &payload, const Address *destination = nullptr);
+
+    //! Submit the prepared writes
+    void flush();
+
+    //! \returns `true` if a datagram from the last batch is left, or the last batch was full
+    bool datagram_waiting() const { return not _received.empty() or _batch_filled; }
+};
+
+//! \class DatagramRing
+//! Reading a datagram with [recvfrom(2)](\ref man2::recvfrom) and writing one with
+//! [sendto(2)](\ref man2::sendto) each cost a system call. A DatagramRing reads up to
+//! `depth` datagrams with one [io_uring_enter(2)](\ref man2::io_uring_enter), and writes
+//! the datagrams prepared since the last flush() with another. Reads are only submitted
+//! when no datagram is left from the previous batch; as `fd` is non-blocking, they complete
+//! (with a datagram or with `EAGAIN`) right away. The size of a batch follows the number of
+//! datagrams the last batch found, from 4 up to `depth`.
+//!
+//! A write is dropped, like a datagram lost in the network, if the socket's send buffer is full.
+
+#endif  // SPONGE_LIBSPONGE_DATAGRAM_RING_HH
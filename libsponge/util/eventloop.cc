@@ -2,14 +2,27 @@
 
 #include "util.hh"
 
+#include <algorithm>
+#include <array>
 #include <cerrno>
 #include <stdexcept>
+#include <sys/epoll.h>
 #include <system_error>
 #include <utility>
 #include <vector>
 
 using namespace std;
 
+//! most events reaped by one call to epoll_wait
+static constexpr size_t MAX_EPOLL_EVENTS = 256;
+
+//! \param[in] backend selects poll(2) or epoll(7)
+EventLoop::EventLoop(const Backend backend) : _backend(backend) {
+    if (_backend == Backend::Epoll) {
+        _epoll.emplace(SystemCall("epoll_create1", ::epoll_create1(EPOLL_CLOEXEC)));
+    }
+}
+
 unsigned int EventLoop::Rule::service_count() const {
     return direction == Direction::In ? fd.read_count() : fd.write_count();
 }
@@ -19,6 +32,7 @@ unsigned int EventLoop::Rule::service_count() const {
 //! \param[in] callback is called when `fd` is ready.
 //! \param[in] interest is called by EventLoop::wait_next_event. If it returns `true`, `fd` will
 //!                     be polled, otherwise `fd` will be ignored only for this execution of `wait_next_event.
+//!                     If it is empty, `fd` is always polled.
 //! \param[in] cancel is called when the rule is cancelled (e.g. on hangup, EOF, or closure).
 void EventLoop::add_rule(const FileDescriptor &fd,
                          const Direction direction,
@@ -26,6 +40,90 @@ void EventLoop::add_rule(const FileDescriptor &fd,
                          const InterestT &interest,
                          const CallbackT &cancel) {
     _rules.push_back({fd.duplicate(), direction, callback, interest, cancel});
+    if (_backend == Backend::Poll) {
+        return;
+    }
+
+    const RuleIt rule = prev(_rules.end());
+    auto existing = _registrations.find(fd.fd_num());
+    if (existing != _registrations.end()) {
+        // a closed fd leaves the epoll set by itself, and its number may have been reused since
+        const auto &old = existing->second.in ? existing->second.in : existing->second.out;
+        if (old and old.value()->fd.closed()) {
+            if (existing->second.in) {
+                _cancel(existing->second.in.value());
+            }
+            if (existing->second.out) {
+                _cancel(existing->second.out.value());
+            }
+        }
+    }
+
+    Registration &registration = _registrations[fd.fd_num()];
+    auto &slot = direction == Direction::In ? registration.in : registration.out;
+    if (slot) {
+        _rules.erase(rule);
+        throw runtime_error("EventLoop: fd already has a rule for this direction");
+    }
+    slot = rule;
+    if (fd.closed()) {
+        _closed_fds->push_back(fd.fd_num());
+    } else {
+        rule->fd.watch_close(_closed_fds);
+    }
+    if (rule->interest) {
+        _dynamic_rules.push_back(rule);
+    } else {
+        _arm(rule, true);
+    }
+}
+
+void EventLoop::_arm(const RuleIt rule, const bool armed) {
+    if (rule->armed == armed) {
+        return;
+    }
+    rule->armed = armed;
+    _armed_rules += armed ? 1 : -1;
+
+    const int fd_num = rule->fd.fd_num();
+    Registration &registration = _registrations.at(fd_num);
+    uint32_t events = 0;
+    if (registration.in and registration.in.value()->armed) {
+        events |= EPOLLIN;
+    }
+    if (registration.out and registration.out.value()->armed) {
+        events |= EPOLLOUT;
+    }
+
+    // an fd with no armed rule is taken out of the epoll set, so that a hangup can't wake us up
+    epoll_event event{events, {}};
+    event.data.fd = fd_num;
+    if (rule->fd.closed()) {
+        // already gone from the epoll set
+    } else if (registration.events == 0) {
+        SystemCall("epoll_ctl", ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_ADD, fd_num, &event));
+    } else if (events == 0) {
+        SystemCall("epoll_ctl", ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_DEL, fd_num, nullptr));
+    } else {
+        SystemCall("epoll_ctl", ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_MOD, fd_num, &event));
+    }
+    registration.events = events;
+}
+
+void EventLoop::_cancel(const RuleIt rule) {
+    _arm(rule, false);
+    rule->cancel();
+
+    const int fd_num = rule->fd.fd_num();
+    Registration &registration = _registrations.at(fd_num);
+    (rule->direction == Direction::In ? registration.in : registration.out).reset();
+    if (not registration.in and not registration.out) {
+        _registrations.erase(fd_num);
+    }
+    if (rule->interest) {
+        _dynamic_rules.erase(find(_dynamic_rules.begin(), _dynamic_rules.end(), rule));
+    }
+    _rules.erase(rule);
 }
 
 //! \param[in] timeout_ms is the timeout value passed to [poll(2)](\ref man2::poll); `wait_next_event`
@@ -59,6 +157,10 @@ void EventLoop::add_rule(const FileDescriptor &fd,
 //! will result in a busy loop (poll returns on a ready file descriptor; file descriptor is not read or
 //! written, so it is still ready; the next call to poll will immediately return).
 EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
+    return _backend == Backend::Poll ? _wait_next_event_poll(timeout_ms) : _wait_next_event_epoll(timeout_ms);
+}
+
+EventLoop::Result EventLoop::_wait_next_event_poll(const int timeout_ms) {
     vector<pollfd> pollfds{};
     pollfds.reserve(_rules.size());
     bool something_to_poll = false;
@@ -79,7 +181,7 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
             continue;
         }
 
-        if (this_rule.interest()) {
+        if (this_rule.interested()) {
             pollfds.push_back({this_rule.fd.fd_num(), static_cast<short>(this_rule.direction), 0});
             something_to_poll = true;
         } else {
@@ -132,7 +234,7 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
             this_rule.callback();
 
             // only check for busy wait if we're not canceling or exiting
-            if (count_before == this_rule.service_count() and this_rule.interest()) {
+            if (count_before == this_rule.service_count() and this_rule.interested()) {
                 throw runtime_error(
                     "EventLoop: busy wait detected: callback did not read/write fd and is still interested");
             }
@@ -143,3 +245,97 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
 
     return Result::Success;
 }
+
+//! \details Same behavior as with Backend::Poll, except that only the rules with an interest callback
+//! and the rules of the fds closed since the last call are visited before waiting, and only the
+//! ready fds after.
+EventLoop::Result EventLoop::_wait_next_event_epoll(const int timeout_ms) {
+    // a closed fd leaves the epoll set without a word, so its rules must be found and canceled here
+    for (const int fd_num : exchange(*_closed_fds, {})) {
+        const auto registration = _registrations.find(fd_num);
+        if (registration == _registrations.end()) {
+            continue;
+        }
+        // NOTE: _cancel() may erase the registration
+        for (const auto &rule : {registration->second.in, registration->second.out}) {
+            if (rule and rule.value()->fd.closed()) {
+                _cancel(rule.value());
+            }
+        }
+    }
+
+    // update the registrations of the rules whose interest may have changed
+    for (size_t i = 0; i < _dynamic_rules.size();) {  // NOTE: _cancel() erases the rule from _dynamic_rules
+        const RuleIt rule = _dynamic_rules[i];
+        if ((rule->direction == Direction::In and rule->fd.eof()) or rule->fd.closed()) {
+            _cancel(rule);
+            continue;
+        }
+        _arm(rule, rule->interest());
+        ++i;
+    }
+
+    // quit if there is nothing left to wait for
+    if (_armed_rules == 0) {
+        return Result::Exit;
+    }
+
+    array<epoll_event, MAX_EPOLL_EVENTS> events{};
+    int n_events = 0;
+    try {
+        n_events = SystemCall("epoll_wait", ::epoll_wait(_epoll->fd_num(), events.data(), events.size(), timeout_ms));
+        if (n_events == 0) {
+            return Result::Timeout;
+        }
+    } catch (unix_error const &e) {
+        if (e.code().value() == EINTR) {
+            return Result::Exit;
+        }
+        throw;
+    }
+
+    for (int i = 0; i < n_events; ++i) {
+        const int fd_num = events[i].data.fd;
+        const uint32_t revents = events[i].events;
+        if (revents & EPOLLERR) {
+            throw runtime_error("EventLoop: error on polled file descriptor");
+        }
+
+        for (const Direction direction : {Direction::In, Direction::Out}) {
+            // look the rule up again, as an earlier callback may have added or canceled rules
+            const auto registration = _registrations.find(fd_num);
+            if (registration == _registrations.end()) {
+                break;
+            }
+            const auto rule = direction == Direction::In ? registration->second.in : registration->second.out;
+            if (not rule or not rule.value()->armed) {
+                continue;
+            }
+            const RuleIt this_rule = rule.value();
+
+            const bool ready = revents & (direction == Direction::In ? EPOLLIN : EPOLLOUT);
+            if ((revents & EPOLLHUP) and not ready) {
+                // only a hangup: no more will ever be readable, and it will not be writable again
+                _cancel(this_rule);
+                continue;
+            }
+            if (not ready) {
+                continue;
+            }
+
+            const auto count_before = this_rule->service_count();
+            this_rule->callback();
+
+            if ((this_rule->direction == Direction::In and this_rule->fd.eof()) or this_rule->fd.closed()) {
+                _cancel(this_rule);
+                continue;
+            }
+            if (count_before == this_rule->service_count() and this_rule->interested()) {
+                throw runtime_error(
+                    "EventLoop: busy wait detected: callback did not read/write fd and is still interested");
+            }
+        }
+    }
+
+    return Result::Success;
+}
@@ -3,10 +3,15 @@
 
 #include "file_descriptor.hh"
 
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <list>
+#include <memory>
+#include <optional>
 #include <poll.h>
+#include <unordered_map>
+#include <vector>
 
 //! Waits for events on file descriptors and executes corresponding callbacks.
 class EventLoop {
@@ -17,9 +22,23 @@ class EventLoop {
         Out = POLLOUT  //!< Callback will be triggered when Rule::fd is writable.
     };
 
+    //! The system call that an EventLoop waits with.
+    enum class Backend {
+        Poll,  //!< [poll(2)](\ref man2::poll), with the set of fds rebuilt from the rules on every call.
+        Epoll  //!< [epoll(7)](\ref man7::epoll), with registrations kept in the kernel between calls.
+    };
+
+    //! Returned by each call to EventLoop::wait_next_event.
+    enum class Result {
+        Success,  //!< At least one Rule was triggered.
+        Timeout,  //!< No rules were triggered before timeout.
+        Exit  //!< All rules have been canceled or were uninterested; make no further calls to EventLoop::wait_next_event.
+    };
+
   private:
     using CallbackT = std::function<void(void)>;  //!< Callback for ready Rule::fd
     using InterestT = std::function<bool(void)>;  //!< `true` return indicates Rule::fd should be polled.
+                                                   //!< An empty InterestT is always interested.
 
     //! \brief Specifies a condition and callback that an EventLoop should handle.
     //! \details Created by calling EventLoop::add_rule() or EventLoop::add_cancelable_rule().
@@ -30,30 +49,63 @@ class EventLoop {
         CallbackT callback;   //!< A callback that reads or writes fd.
         InterestT interest;   //!< A callback that returns `true` whenever fd should be polled.
         CallbackT cancel;     //!< A callback that is called when the rule is cancelled (e.g. on hangup)
+        bool armed{false};    //!< With Backend::Epoll, whether fd is registered for Rule::direction.
 
         //! Returns the number of times fd has been read or written, depending on the value of Rule::direction.
         //! \details This function is used internally by EventLoop; you will not need to call it
         unsigned int service_count() const;
+
+        //! Returns `true` if Rule::interest is empty or returns `true`.
+        bool interested() const { return not interest or interest(); }
+    };
+
+    using RuleIt = std::list<Rule>::iterator;  //!< Handle on a rule in EventLoop::_rules
+
+    //! With Backend::Epoll, the rules of one fd and the events it is registered for
+    struct Registration {
+        std::optional<RuleIt> in{};   //!< The Direction::In rule of the fd, if any
+        std::optional<RuleIt> out{};  //!< The Direction::Out rule of the fd, if any
+        uint32_t events{0};           //!< The events registered with epoll_ctl; 0 if not registered
     };
 
+    Backend _backend;          //!< The system call used by wait_next_event.
     std::list<Rule> _rules{};  //!< All rules that have been added and not canceled.
 
+    //! \name Backend::Epoll state
+    //!@{
+    std::optional<FileDescriptor> _epoll{};                   //!< The epoll instance
+    std::unordered_map<int, Registration> _registrations{};  //!< Registrations, by fd number
+    std::vector<RuleIt> _dynamic_rules{};                     //!< Rules with an interest callback
+    size_t _armed_rules{0};                                   //!< Number of rules that are registered
+    //! Numbers of the fds with rules that have been closed since the last call, from FileDescriptor::watch_close
+    std::shared_ptr<std::vector<int>> _closed_fds{std::make_shared<std::vector<int>>()};
+    //!@}
+
+    //! wait_next_event() for Backend::Poll
+    Result _wait_next_event_poll(const int timeout_ms);
+
+    //! wait_next_event() for Backend::Epoll
+    Result _wait_next_event_epoll(const int timeout_ms);
+
+    //! With Backend::Epoll, register or unregister a rule and update its fd's epoll registration
+    void _arm(const RuleIt rule, const bool armed);
+
+    //! With Backend::Epoll, call the rule's cancel callback and delete it
+    void _cancel(const RuleIt rule);
+
   public:
-    //! Returned by each call to EventLoop::wait_next_event.
-    enum class Result {
-        Success,  //!< At least one Rule was triggered.
-        Timeout,  //!< No rules were triggered before timeout.
-        Exit  //!< All rules have been canceled or were uninterested; make no further calls to EventLoop::wait_next_event.
-    };
+    //! Construct an EventLoop that waits with the specified system call.
+    explicit EventLoop(const Backend backend = Backend::Poll);
 
     //! Add a rule whose callback will be called when `fd` is ready in the specified Direction.
     void add_rule(const FileDescriptor &fd,
                   const Direction direction,
                   const CallbackT &callback,
-                  const InterestT &interest = [] { return true; },
+                  const InterestT &interest = {},
                   const CallbackT &cancel = [] {});
 
-    //! Calls [poll(2)](\ref man2::poll) and then executes callback for each ready fd.
+    //! Calls [poll(2)](\ref man2::poll) or [epoll_wait(2)](\ref man2::epoll_wait) and then executes
+    //! callback for each ready fd.
     Result wait_next_event(const int timeout_ms);
 };
 
@@ -69,6 +121,14 @@ using Direction = EventLoop::Direction;
 //! (for Rule::direction == Direction::In) or writable (for Rule::direction == Direction::Out).
 //! Once this occurs, the Rule is canceled, i.e., the EventLoop deletes it.
 //!
+//! With Backend::Poll, every call to EventLoop::wait_next_event evaluates every Rule::interest and
+//! passes every fd to poll, so its cost grows with the number of rules. With Backend::Epoll, fds stay
+//! registered with the kernel between calls, and only the rules that have an interest callback are
+//! evaluated (and re-registered when their interest changes); the cost of a call grows with the
+//! number of ready fds. A rule without an interest callback is then only checked for EOF after its
+//! callback runs, and for closure when its FileDescriptor has been closed since the last call; each
+//! fd can have at most one rule per Direction.
+//!
 //! A Rule installed using EventLoop::add_cancelable_rule will be polled and canceled under the
 //! same conditions, with the additional condition that if Rule::callback returns `true`, the
 //! Rule will be canceled.
@@ -21,6 +21,12 @@ FileDescriptor::FDWrapper::FDWrapper(const int fd) : _fd(fd) {
 void FileDescriptor::FDWrapper::close() {
     SystemCall("close", ::close(_fd));
     _eof = _closed = true;
+    for (const auto &watcher : _close_watchers) {
+        if (const auto closed_fds = watcher.lock()) {
+            closed_fds->push_back(_fd);
+        }
+    }
+    _close_watchers.clear();
 }
 
 FileDescriptor::FDWrapper::~FDWrapper() {
@@ -41,6 +47,17 @@ FileDescriptor::FileDescriptor(const int fd) : _internal_fd(make_shared<FDWrappe
 //! Private constructor used by duplicate()
 FileDescriptor::FileDescriptor(shared_ptr<FDWrapper> other_shared_ptr) : _internal_fd(move(other_shared_ptr)) {}
 
+//! \param[in] closed_fds is the list to append the fd number to; it is only referenced weakly
+void FileDescriptor::watch_close(const shared_ptr<vector<int>> &closed_fds) {
+    auto &watchers = _internal_fd->_close_watchers;
+    // forget the lists that are gone, and watch for each list once
+    watchers.erase(remove_if(watchers.begin(), watchers.end(), [](const auto &watcher) { return watcher.expired(); }),
+                   watchers.end());
+    if (none_of(watchers.begin(), watchers.end(), [&](const auto &watcher) { return watcher.lock() == closed_fds; })) {
+        watchers.push_back(closed_fds);
+    }
+}
+
 //! \returns a copy of this FileDescriptor
 FileDescriptor FileDescriptor::duplicate() const { return FileDescriptor(_internal_fd); }
 
@@ -63,6 +80,27 @@ void FileDescriptor::read(std::string &str, const size_t limit) {
     register_read();
 }
 
+//! \param[in] buffers are the memory regions to read into, as for [readv(2)](\ref man2::readv)
+//! \returns the number of bytes read; fewer bytes than the total size of `buffers` may be read
+size_t FileDescriptor::read(const vector<iovec> &buffers) {
+    size_t size_to_read = 0;
+    for (const auto &buf : buffers) {
+        size_to_read += buf.iov_len;
+    }
+
+    const ssize_t bytes_read = SystemCall("readv", ::readv(fd_num(), buffers.data(), buffers.size()));
+    if (size_to_read > 0 && bytes_read == 0) {
+        _internal_fd->_eof = true;
+    }
+    if (bytes_read > static_cast<ssize_t>(size_to_read)) {
+        throw runtime_error("readv() read more than requested");
+    }
+
+    register_read();
+
+    return bytes_read;
+}
+
 //! \param[in] limit is the maximum number of bytes to read; fewer bytes may be returned
 //! \returns a vector of bytes read
 string FileDescriptor::read(const size_t limit) {
@@ -5,8 +5,10 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <limits>
 #include <memory>
+#include <vector>
 
 //! A reference-counted handle to a file descriptor
 class FileDescriptor {
@@ -19,6 +21,8 @@ class FileDescriptor {
         bool _closed = false;       //!< Flag indicating whether FDWrapper::_fd has been closed
         unsigned _read_count = 0;   //!< The number of times FDWrapper::_fd has been read
         unsigned _write_count = 0;  //!< The numberof times FDWrapper::_fd has been written
+        //! Lists that FDWrapper::_fd is appended to when it is closed
+        std::vector<std::weak_ptr<std::vector<int>>> _close_watchers{};
 
         //! Construct from a file descriptor number returned by the kernel
         explicit FDWrapper(const int fd);
@@ -61,6 +65,10 @@ class FileDescriptor {
     //! Read up to `limit` bytes into `str` (caller can allocate storage)
     void read(std::string &str, const size_t limit = std::numeric_limits<size_t>::max());
 
+    //! Read into the caller's memory described by `buffers`, filling them in order
+    //! \returns the number of bytes read
+    size_t read(const std::vector<iovec> &buffers);
+
     //! Write a string, possibly blocking until all is written
     size_t write(const char *str, const bool write_all = true) { return write(BufferViewList(str), write_all); }
 
@@ -98,6 +106,9 @@ class FileDescriptor {
     unsigned int write_count() const { return _internal_fd->_write_count; }
     //!@}
 
+    //! Append fd_num() to `closed_fds` when the file descriptor is closed, if the list still exists then
+    void watch_close(const std::shared_ptr<std::vector<int>> &closed_fds);
+
     //! \name Copy/move constructor/assignment operators
     //! FileDescriptor can be moved, but cannot be copied (but see duplicate())
     //!@{
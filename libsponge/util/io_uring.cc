@@ -0,0 +1,204 @@
+#include "io_uring.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace std;
+
+//! [io_uring_setup(2)](\ref man2::io_uring_setup), which libc does not wrap
+static int io_uring_setup(const unsigned entries, io_uring_params &params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+}
+
+//! Map `length` bytes of the io_uring `ring` at `offset`
+static void *map_ring(const FileDescriptor &ring, const size_t length, const off_t offset) {
+    void *const address =
+        ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd_num(), offset);
+    if (address == MAP_FAILED) {
+        throw unix_error("mmap");
+    }
+    return address;
+}
+
+//! \param[in] entries is the size of the submission queue (rounded up to a power of two by the kernel)
+//! \param[in] buffer_count is the number of buffers to register
+//! \param[in] buffer_size is the size of each buffer
+IoUring::IoUring(const unsigned entries, const size_t buffer_count, const size_t buffer_size)
+    : IoUring(entries, buffer_count, buffer_size, io_uring_params{}) {}
+
+IoUring::IoUring(const unsigned entries,
+                 const size_t buffer_count,
+                 const size_t buffer_size,
+                 io_uring_params params)
+    : _ring(SystemCall("io_uring_setup", io_uring_setup(entries, params))), _buffer_size(buffer_size) {
+    try {
+        const size_t sq_length = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        const size_t cq_length = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            const size_t length = max(sq_length, cq_length);
+            _sq_mapping = {map_ring(_ring, length, IORING_OFF_SQ_RING), length};
+            _cq_mapping = _sq_mapping;
+        } else {
+            _sq_mapping = {map_ring(_ring, sq_length, IORING_OFF_SQ_RING), sq_length};
+            _cq_mapping = {map_ring(_ring, cq_length, IORING_OFF_CQ_RING), cq_length};
+        }
+        const size_t sqes_length = params.sq_entries * sizeof(io_uring_sqe);
+        _sqe_mapping = {map_ring(_ring, sqes_length, IORING_OFF_SQES), sqes_length};
+    } catch (...) {
+        _unmap();
+        throw;
+    }
+
+    char *const sq = static_cast<char *>(_sq_mapping.address);
+    _sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    _sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    _sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    _sq_entries = params.sq_entries;
+    _sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    _sqes = static_cast<io_uring_sqe *>(_sqe_mapping.address);
+    _sq_prepared = *_sq_tail;
+
+    char *const cq = static_cast<char *>(_cq_mapping.address);
+    _cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    _cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    _cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    _buffers.resize(buffer_count * buffer_size);
+    vector<iovec> iovecs;
+    for (size_t i = 0; i < buffer_count; ++i) {
+        iovecs.push_back({buffer(i), buffer_size});
+    }
+    try {
+        SystemCall("io_uring_register",
+                   static_cast<int>(::syscall(
+                       __NR_io_uring_register, _ring.fd_num(), IORING_REGISTER_BUFFERS, iovecs.data(), iovecs.size())));
+    } catch (...) {
+        _unmap();
+        throw;
+    }
+}
+
+IoUring::~IoUring() { _unmap(); }
+
+void IoUring::_unmap() {
+    if (_sqe_mapping.address) {
+        ::munmap(_sqe_mapping.address, _sqe_mapping.length);
+    }
+    if (_cq_mapping.address and _cq_mapping.address != _sq_mapping.address) {
+        ::munmap(_cq_mapping.address, _cq_mapping.length);
+    }
+    if (_sq_mapping.address) {
+        ::munmap(_sq_mapping.address, _sq_mapping.length);
+    }
+    _sq_mapping = _cq_mapping = _sqe_mapping = {nullptr, 0};
+}
+
+io_uring_sqe &IoUring::_next_sqe() {
+    if (prepared() == _sq_entries) {
+        submit();
+        if (prepared() == _sq_entries) {
+            throw runtime_error("IoUring: submission queue full");
+        }
+    }
+    const unsigned index = _sq_prepared & _sq_mask;
+    _sq_array[index] = index;
+    _sq_prepared++;
+    memset(&_sqes[index], 0, sizeof(io_uring_sqe));
+    return _sqes[index];
+}
+
+//! \param[in] fd is the file descriptor to read from
+//! \param[in] index is the registered buffer to read into
+//! \param[in] user_data identifies the operation in its Completion
+void IoUring::read_fixed(const FileDescriptor &fd, const size_t index, const uint64_t user_data) {
+    io_uring_sqe &sqe = _next_sqe();
+    sqe.opcode = IORING_OP_READ_FIXED;
+    sqe.fd = fd.fd_num();
+    sqe.addr = reinterpret_cast<uint64_t>(buffer(index));
+    sqe.len = _buffer_size;
+    sqe.off = uint64_t(-1);  // the current file position, which a TUN device does not have
+    sqe.rw_flags = RWF_NOWAIT;
+    sqe.buf_index = index;
+    sqe.user_data = user_data;
+}
+
+//! \param[in] fd is the file descriptor to write to
+//! \param[in] index is the registered buffer to write from
+//! \param[in] length is the number of bytes to write
+//! \param[in] user_data identifies the operation in its Completion
+void IoUring::write_fixed(const FileDescriptor &fd, const size_t index, const size_t length, const uint64_t user_data) {
+    io_uring_sqe &sqe = _next_sqe();
+    sqe.opcode = IORING_OP_WRITE_FIXED;
+    sqe.fd = fd.fd_num();
+    sqe.addr = reinterpret_cast<uint64_t>(buffer(index));
+    sqe.len = length;
+    sqe.off = uint64_t(-1);
+    sqe.rw_flags = RWF_NOWAIT;
+    sqe.buf_index = index;
+    sqe.user_data = user_data;
+}
+
+//! \param[in] fd is the socket to receive from
+//! \param[in] message describes where to put the datagram and its source address
+//! \param[in] user_data identifies the operation in its Completion
+//! \note the result of a receive is the datagram's full length, even if `message` could not hold it
+void IoUring::recvmsg(const FileDescriptor &fd, msghdr &message, const uint64_t user_data) {
+    io_uring_sqe &sqe = _next_sqe();
+    sqe.opcode = IORING_OP_RECVMSG;
+    sqe.fd = fd.fd_num();
+    sqe.addr = reinterpret_cast<uint64_t>(&message);
+    sqe.len = 1;
+    sqe.msg_flags = MSG_TRUNC | MSG_DONTWAIT;
+    sqe.user_data = user_data;
+}
+
+//! \param[in] fd is the socket to send with
+//! \param[in] message describes the datagram and its destination address
+//! \param[in] user_data identifies the operation in its Completion
+void IoUring::sendmsg(const FileDescriptor &fd, const msghdr &message, const uint64_t user_data) {
+    io_uring_sqe &sqe = _next_sqe();
+    sqe.opcode = IORING_OP_SENDMSG;
+    sqe.fd = fd.fd_num();
+    sqe.addr = reinterpret_cast<uint64_t>(&message);
+    sqe.len = 1;
+    sqe.msg_flags = MSG_DONTWAIT;
+    sqe.user_data = user_data;
+}
+
+//! \param[in] wait_for is the number of completions to wait for (counting those already posted)
+//! \details Makes one [io_uring_enter(2)](\ref man2::io_uring_enter) system call, or none if there
+//! is nothing to submit or wait for.
+void IoUring::submit(const unsigned wait_for) {
+    const unsigned to_submit = prepared();
+    __atomic_store_n(_sq_tail, _sq_prepared, __ATOMIC_RELEASE);
+    if (to_submit == 0 and wait_for == 0) {
+        return;
+    }
+    SystemCall("io_uring_enter",
+               static_cast<int>(::syscall(__NR_io_uring_enter,
+                                          _ring.fd_num(),
+                                          to_submit,
+                                          wait_for,
+                                          wait_for > 0 ? IORING_ENTER_GETEVENTS : 0,
+                                          nullptr,
+                                          0)));
+}
+
+optional<IoUring::Completion> IoUring::reap() {
+    const unsigned head = *_cq_head;
+    if (head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE)) {
+        return {};
+    }
+    const io_uring_cqe &cqe = _cqes[head & _cq_mask];
+    const Completion completion{cqe.user_data, cqe.res};
+    __atomic_store_n(_cq_head, head + 1, __ATOMIC_RELEASE);
+    return completion;
+}
@@ -0,0 +1,123 @@
+#ifndef SPONGE_LIBSPONGE_IO_URING_HH
+#define SPONGE_LIBSPONGE_IO_URING_HH
+
+#include "file_descriptor.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <optional>
+#include <sys/socket.h>
+#include <vector>
+
+//! An [io_uring(7)](\ref man7::io_uring) instance with a pool of registered buffers
+class IoUring {
+  public:
+    //! The outcome of one submitted operation
+    struct Completion {
+        uint64_t user_data;  //!< The value given when the operation was prepared
+        int32_t result;      //!< What the system call would have returned, or -errno
+    };
+
+  private:
+    //! A region of memory shared with the kernel
+    struct Mapping {
+        void *address;  //!< Start of the mapping
+        size_t length;  //!< Length of the mapping
+    };
+
+    FileDescriptor _ring;              //!< The io_uring instance
+    Mapping _sq_mapping{nullptr, 0};   //!< The submission queue ring
+    Mapping _cq_mapping{nullptr, 0};   //!< The completion queue ring (the same memory as the SQ ring, usually)
+    Mapping _sqe_mapping{nullptr, 0};  //!< The submission queue entries
+
+    //! \name Submission queue
+    //!@{
+    unsigned *_sq_head{};     //!< Next entry the kernel will consume
+    unsigned *_sq_tail{};     //!< One past the last entry handed to the kernel
+    unsigned _sq_mask{};      //!< Mask that turns a position into an index
+    unsigned _sq_entries{};   //!< Number of entries
+    unsigned *_sq_array{};    //!< Indices of the entries to consume, by position
+    io_uring_sqe *_sqes{};    //!< The entries
+    unsigned _sq_prepared{};  //!< One past the last entry prepared
+    //!@}
+
+    //! \name Completion queue
+    //!@{
+    unsigned *_cq_head{};   //!< Next completion to reap
+    unsigned *_cq_tail{};   //!< One past the last completion posted by the kernel
+    unsigned _cq_mask{};    //!< Mask that turns a position into an index
+    io_uring_cqe *_cqes{};  //!< The completions
+    //!@}
+
+    std::vector<char> _buffers{};  //!< The registered buffers, back to back
+    size_t _buffer_size;           //!< Size of each registered buffer
+
+    //! Set up the rings of the io_uring that `params` describes, and register the buffers
+    IoUring(const unsigned entries, const size_t buffer_count, const size_t buffer_size, io_uring_params params);
+
+    //! Unmap whichever rings are mapped
+    void _unmap();
+
+    //! A cleared submission queue entry (after submitting, if the queue is full)
+    io_uring_sqe &_next_sqe();
+
+  public:
+    //! Create an io_uring with room for `entries` operations, and register `buffer_count`
+    //! buffers of `buffer_size` bytes each
+    IoUring(const unsigned entries, const size_t buffer_count, const size_t buffer_size);
+
+    //! Unmap the rings; the io_uring is closed with its FileDescriptor
+    ~IoUring();
+
+    //! \name
+    //! An IoUring shares memory with the kernel, so it cannot be copied or moved
+
+    //!@{
+    IoUring(const IoUring &other) = delete;
+    IoUring &operator=(const IoUring &other) = delete;
+    IoUring(IoUring &&other) = delete;
+    IoUring &operator=(IoUring &&other) = delete;
+    //!@}
+
+    //! \returns registered buffer `index`
+    char *buffer(const size_t index) { return _buffers.data() + index * _buffer_size; }
+
+    //! \returns the size of each registered buffer
+    size_t buffer_size() const { return _buffer_size; }
+
+    //! Prepare a read of up to buffer_size() bytes from `fd` into registered buffer `index`
+    void read_fixed(const FileDescriptor &fd, const size_t index, const uint64_t user_data);
+
+    //! Prepare a write of `length` bytes from registered buffer `index` to `fd`
+    void write_fixed(const FileDescriptor &fd, const size_t index, const size_t length, const uint64_t user_data);
+
+    //! Prepare a [recvmsg(2)](\ref man2::recvmsg); `message` must stay valid until the operation completes
+    void recvmsg(const FileDescriptor &fd, msghdr &message, const uint64_t user_data);
+
+    //! Prepare a [sendmsg(2)](\ref man2::sendmsg); `message` must stay valid until the operation completes
+    void sendmsg(const FileDescriptor &fd, const msghdr &message, const uint64_t user_data);
+
+    //! Hand the prepared operations to the kernel, and wait until at least `wait_for` completions are posted
+    void submit(const unsigned wait_for = 0);
+
+    //! \returns the oldest completion not yet reaped, or an empty value if there is none (without a system call)
+    std::optional<Completion> reap();
+
+    //! \returns the number of operations prepared and not yet submitted
+    unsigned prepared() const { return _sq_prepared - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE); }
+};
+
+//! \class IoUring
+//! The rings are set up with raw system calls and the definitions in `<linux/io_uring.h>`, so no
+//! library beyond the kernel headers is needed. Operations are prepared into the submission queue
+//! with no system call, and any number of them are handed to the kernel by one call to submit();
+//! completions are read straight out of the completion queue.
+//!
+//! Every operation is non-blocking: one that cannot complete at once fails with `EAGAIN`, rather
+//! than waiting in the kernel.
+//!
+//! The registered buffers are pinned by the kernel once, instead of on every operation, for
+//! read_fixed() and write_fixed(). Other operations can use them as ordinary memory.
+
+#endif  // SPONGE_LIBSPONGE_IO_URING_HH
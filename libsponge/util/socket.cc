@@ -2,6 +2,7 @@
 
 #include "util.hh"
 
+#include <cerrno>
 #include <cstddef>
 #include <stdexcept>
 #include <unistd.h>
@@ -85,17 +86,30 @@ void Socket::shutdown(const int how) {
 }
 
 //! \note If `mtu` is too small to hold the received datagram, this method throws a std::runtime_error
-void UDPSocket::recv(received_datagram &datagram, const size_t mtu) {
+void UDPSocket::recv(received_datagram &datagram, const size_t mtu) { _recv(datagram, mtu, 0); }
+
+//! \note If `mtu` is too small to hold the received datagram, this method throws a std::runtime_error
+bool UDPSocket::try_recv(received_datagram &datagram, const size_t mtu) { return _recv(datagram, mtu, MSG_DONTWAIT); }
+
+bool UDPSocket::_recv(received_datagram &datagram, const size_t mtu, const int flags) {
     // receive source address and payload
     Address::Raw datagram_source_address;
     datagram.payload.resize(mtu);
 
     socklen_t fromlen = sizeof(datagram_source_address);
 
-    const ssize_t recv_len = SystemCall(
-        "recvfrom",
-        ::recvfrom(
-            fd_num(), datagram.payload.data(), datagram.payload.size(), MSG_TRUNC, datagram_source_address, &fromlen));
+    const ssize_t recv_len = SystemCall("recvfrom",
+                                        ::recvfrom(fd_num(),
+                                                   datagram.payload.data(),
+                                                   datagram.payload.size(),
+                                                   MSG_TRUNC | flags,
+                                                   datagram_source_address,
+                                                   &fromlen),
+                                        (flags & MSG_DONTWAIT) ? EAGAIN : 0);
+    if (recv_len < 0) {
+        datagram.payload.clear();
+        return false;
+    }
 
     if (recv_len > ssize_t(mtu)) {
         throw runtime_error("recvfrom (oversized datagram)");
@@ -104,6 +118,7 @@ void UDPSocket::recv(received_datagram &datagram, const size_t mtu) {
     register_read();
     datagram.source_address = {datagram_source_address, fromlen};
     datagram.payload.resize(recv_len);
+    return true;
 }
 
 UDPSocket::received_datagram UDPSocket::recv(const size_t mtu) {
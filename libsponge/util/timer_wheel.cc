@@ -0,0 +1,163 @@
+#include "timer_wheel.hh"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+using namespace std;
+
+//! \returns the index of the slot of width 64^level ms that holds `time`
+static size_t index_at(const uint64_t time, const size_t level, const size_t slot_bits) {
+    return (time >> (slot_bits * level)) & ((size_t(1) << slot_bits) - 1);
+}
+
+list<TimerWheel::TimerId> &TimerWheel::_slot(const size_t level, const size_t index) {
+    if (level == DUE) {
+        return _due;
+    }
+    return level == OVERFLOW ? _overflow : _slots.at(level).at(index);
+}
+
+void TimerWheel::_file(const TimerId id, Timer &timer) {
+    const uint64_t deadline = timer.deadline;
+
+    // the lowest level whose slots are narrower than the distance to the deadline
+    timer.level = deadline < _time ? DUE : 0;
+    while (timer.level < LEVELS and (deadline >> (SLOT_BITS * (timer.level + 1))) !=
+                                        (_time >> (SLOT_BITS * (timer.level + 1)))) {
+        timer.level++;
+    }
+    timer.index = timer.level < LEVELS ? index_at(deadline, timer.level, SLOT_BITS) : 0;
+
+    list<TimerId> &slot = _slot(timer.level, timer.index);
+    timer.entry = slot.insert(slot.end(), id);
+    if (timer.level < LEVELS) {
+        _occupied.at(timer.level) |= uint64_t(1) << timer.index;
+    }
+}
+
+void TimerWheel::_set_time(const uint64_t time) {
+    _time = time;
+    if (index_at(_time, 0, SLOT_BITS) != 0) {
+        return;
+    }
+
+    // entering a new slot at some levels: refile its timers, from the top level down
+    for (size_t level = LEVELS; level >= 1; --level) {
+        if (_time % (uint64_t(1) << (SLOT_BITS * level)) != 0) {
+            continue;
+        }
+        const size_t index = level < LEVELS ? index_at(_time, level, SLOT_BITS) : 0;
+        list<TimerId> refile{};
+        refile.swap(_slot(level, index));
+        if (level < LEVELS) {
+            _occupied.at(level) &= ~(uint64_t(1) << index);
+        }
+        for (const TimerId id : refile) {
+            _file(id, _timers.at(id));
+        }
+    }
+}
+
+void TimerWheel::_expire_front(list<TimerId> &slot) {
+    const auto timer = _timers.find(slot.front());
+    slot.pop_front();
+    const CallbackT callback = move(timer->second.callback);
+    _timers.erase(timer);
+    callback();
+}
+
+void TimerWheel::_expire_current_slot() {
+    const size_t index = index_at(_time, 0, SLOT_BITS);
+    list<TimerId> &slot = _slots.at(0).at(index);
+    // NOTE: a callback may schedule or cancel timers, including in this slot and in the due list
+    while (not _due.empty() or not slot.empty()) {
+        _expire_front(_due.empty() ? slot : _due);
+    }
+    _occupied.at(0) &= ~(uint64_t(1) << index);
+}
+
+//! \param[in] deadline is the time at which to call `callback`
+//! \param[in] callback is called by the advance() that reaches `deadline`
+//! \returns an id that can be passed to cancel()
+TimerWheel::TimerId TimerWheel::schedule(const uint64_t deadline, const CallbackT &callback) {
+    const TimerId id = _next_id++;
+    _file(id, _timers.emplace(id, Timer{deadline, callback}).first->second);
+    return id;
+}
+
+//! \param[in] id is the id returned by schedule()
+bool TimerWheel::cancel(const TimerId id) {
+    const auto timer = _timers.find(id);
+    if (timer == _timers.end()) {
+        return false;
+    }
+    list<TimerId> &slot = _slot(timer->second.level, timer->second.index);
+    slot.erase(timer->second.entry);
+    if (slot.empty() and timer->second.level < LEVELS) {
+        _occupied.at(timer->second.level) &= ~(uint64_t(1) << timer->second.index);
+    }
+    _timers.erase(timer);
+    return true;
+}
+
+//! \param[in] now is the current time, in ms
+void TimerWheel::advance(const uint64_t now) {
+    while (not _due.empty()) {
+        _expire_front(_due);
+    }
+    while (_time <= now) {
+        if (_timers.empty()) {
+            _time = now + 1;
+            return;
+        }
+        _expire_current_slot();
+
+        // skip to the next occupied slot of the lowest level that has one (entering it moves its timers
+        // down), or to the end of the top level (which refiles the overflow); the slots in between are empty
+        uint64_t next = ((_time >> (SLOT_BITS * LEVELS)) + 1) << (SLOT_BITS * LEVELS);
+        for (size_t level = 0; level < LEVELS; ++level) {
+            const uint64_t later = _occupied.at(level) & ~((uint64_t(2) << index_at(_time, level, SLOT_BITS)) - 1);
+            if (later) {
+                const size_t window_bits = SLOT_BITS * (level + 1);
+                const uint64_t window_start = (_time >> window_bits) << window_bits;
+                next = window_start + (uint64_t(__builtin_ctzll(later)) << (SLOT_BITS * level));
+                break;
+            }
+        }
+        _set_time(min(next, now + 1));
+    }
+}
+
+std::optional<uint64_t> TimerWheel::next_deadline() const {
+    if (_timers.empty()) {
+        return {};
+    }
+
+    const auto earliest = [&](const list<TimerId> &slot) {
+        uint64_t deadline = numeric_limits<uint64_t>::max();
+        for (const TimerId id : slot) {
+            deadline = min(deadline, _timers.at(id).deadline);
+        }
+        return deadline;
+    };
+    if (not _due.empty()) {
+        return earliest(_due);
+    }
+
+    // level 0 holds the timers of the current 64 ms, one slot per ms
+    const size_t index = index_at(_time, 0, SLOT_BITS);
+    const uint64_t current = _occupied.at(0) & (~uint64_t(0) << index);
+    if (current) {
+        return _time - index + __builtin_ctzll(current);
+    }
+
+    // otherwise the earliest timer is in the first occupied slot after the current one at some level
+    for (size_t level = 1; level < LEVELS; ++level) {
+        const uint64_t later = _occupied.at(level) & ~((uint64_t(2) << index_at(_time, level, SLOT_BITS)) - 1);
+        if (later) {
+            return earliest(_slots.at(level).at(__builtin_ctzll(later)));
+        }
+    }
+    return earliest(_overflow);
+}
@@ -0,0 +1,103 @@
+#ifndef SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <optional>
+#include <unordered_map>
+
+//! Hierarchical timing wheel: calls callbacks at deadlines given in ms
+class TimerWheel {
+  public:
+    using TimerId = uint64_t;                     //!< Handle on a scheduled timer
+    using CallbackT = std::function<void(void)>;  //!< Called when a timer expires
+
+  private:
+    static constexpr size_t SLOT_BITS = 6;                          //!< log2 of the number of slots per level
+    static constexpr size_t SLOTS = size_t(1) << SLOT_BITS;        //!< Slots per level
+    static constexpr size_t LEVELS = 4;                             //!< Levels; the wheel spans 2^24 ms (4.6 h)
+    static constexpr size_t OVERFLOW = LEVELS;                      //!< "Level" of the timers beyond the top level
+    static constexpr size_t DUE = LEVELS + 1;                       //!< "Level" of the timers already due
+
+    //! A scheduled timer and where it is filed
+    struct Timer {
+        uint64_t deadline;                      //!< Time at which the timer expires
+        CallbackT callback;                     //!< Called when the timer expires
+        size_t level{0};                        //!< Level of the slot that holds the timer, or OVERFLOW or DUE
+        size_t index{0};                        //!< Index of the slot within its level
+        std::list<TimerId>::iterator entry{};  //!< The timer's entry in its slot
+    };
+
+    //! Every timer that has been scheduled and has neither expired nor been canceled
+    std::unordered_map<TimerId, Timer> _timers{};
+
+    //! Timers by level and slot. Level k holds the timers that expire in a later slot of width
+    //! 64^k ms than the current time, within the current slot of the level above.
+    std::array<std::array<std::list<TimerId>, SLOTS>, LEVELS> _slots{};
+
+    //! Bit i of _occupied[k] is set if _slots[k][i] is not empty
+    std::array<uint64_t, LEVELS> _occupied{};
+
+    //! Timers beyond the span of the top level
+    std::list<TimerId> _overflow{};
+
+    //! Timers scheduled with a deadline that had already passed
+    std::list<TimerId> _due{};
+
+    //! Every timer with an earlier deadline has expired
+    uint64_t _time;
+
+    //! Id of the next timer to be scheduled
+    TimerId _next_id{0};
+
+    //! The slot (or the overflow or due list) at `level` and `index`
+    std::list<TimerId> &_slot(const size_t level, const size_t index);
+
+    //! File a timer into the level and slot that its deadline falls in
+    void _file(const TimerId id, Timer &timer);
+
+    //! Set the current time, and move the timers of the slots it enters down to lower levels
+    void _set_time(const uint64_t time);
+
+    //! Remove the first timer of a slot and call its callback
+    void _expire_front(std::list<TimerId> &slot);
+
+    //! Call the callbacks of the timers that are due and of those that expire at the current time
+    void _expire_current_slot();
+
+  public:
+    //! Construct a wheel whose current time is `now`
+    explicit TimerWheel(const uint64_t now = 0) : _time(now) {}
+
+    //! Call `callback` at time `deadline` (or at the next advance(), if the wheel has advanced past `deadline`)
+    TimerId schedule(const uint64_t deadline, const CallbackT &callback);
+
+    //! Cancel a timer
+    //! \returns `false` if the timer has already expired or been canceled
+    bool cancel(const TimerId id);
+
+    //! Call the callbacks of all timers whose deadline is at or before `now`, in order of deadline
+    //! (except that timers scheduled after the wheel passed their deadline go first)
+    void advance(const uint64_t now);
+
+    //! \returns the earliest deadline of any timer, or an empty value if none is scheduled
+    std::optional<uint64_t> next_deadline() const;
+
+    //! \returns the number of scheduled timers
+    size_t size() const { return _timers.size(); }
+};
+
+//! \class TimerWheel
+//! Scheduling and canceling a timer take constant time, whatever the number of timers, and
+//! advance() does work in proportion to the timers that expire plus one step per occupied slot
+//! (at any level) that the time passes, and one per 2^24 ms while only the overflow holds timers;
+//! empty slots are skipped using a bitmap of each level. Timers are kept to the ms. A timer far in the future waits in
+//! an upper level and moves down a level each time the current time reaches its slot there
+//! (the "cascade" of [Varghese and Lauck](https://doi.org/10.1145/41457.37504)).
+//!
+//! An event loop sleeps until next_deadline() and then calls advance() with the current time.
+
+#endif  // SPONGE_LIBSPONGE_TIMER_WHEEL_HH
@@ -10,6 +10,9 @@
 
 using namespace std;
 
+//! calls to SystemCall() made by this thread
+static thread_local uint64_t system_calls = 0;
+
 //! \returns the number of milliseconds since the program started
 uint64_t timestamp_ms() {
     using time_point = std::chrono::steady_clock::time_point;
@@ -40,6 +43,7 @@ uint64_t timestamp_ms() {
 //! }
 //! ~~~
 int SystemCall(const char *attempt, const int return_value, const int errno_mask) {
+    ++system_calls;
     if (return_value >= 0 || errno == errno_mask) {
         return return_value;
     }
@@ -55,6 +59,10 @@ int SystemCall(const string &attempt, const int return_value, const int errno_ma
     return SystemCall(attempt.c_str(), return_value, errno_mask);
 }
 
+//! \details Counts the calls made from this thread only, e.g. to compare how many system calls
+//! two ways of doing the same I/O take.
+uint64_t system_call_count() { return system_calls; }
+
 //! \details A properly seeded mt19937 generator takes a lot of entropy!
 //!
 //! This code borrows from the following:
@@ -45,6 +45,9 @@ int SystemCall(const char *attempt, const int return_value, const int errno_mask
 //! Version of SystemCall that takes a C++ std::string
 int SystemCall(const std::string &attempt, const int return_value, const int errno_mask = 0);
 
+//! Number of system calls that the calling thread has checked with SystemCall()
+uint64_t system_call_count();
+
 //! Seed a fast random generator
 std::mt19937 get_random_generator();
 
@@ -0,0 +1,77 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ByteStreamTestHarness test{"chunked write-write-pop-peek", 15, true};
+
+            test.execute(Write{"cat"});
+            test.execute(Write{"tac"});
+
+            test.execute(BytesWritten{6});
+            test.execute(RemainingCapacity{9});
+            test.execute(BufferSize{6});
+            test.execute(Peek{"cattac"});
+
+            test.execute(Pop{4});
+
+            test.execute(BytesRead{4});
+            test.execute(RemainingCapacity{13});
+            test.execute(BufferSize{2});
+            test.execute(Peek{"ac"});
+
+            test.execute(EndInput{});
+            test.execute(Pop{2});
+
+            test.execute(BufferEmpty{true});
+            test.execute(Eof{true});
+        }
+
+        {
+            ByteStreamTestHarness test{"chunked overwrite-pop-overwrite", 4, true};
+
+            test.execute(Write{"cat"}.with_bytes_written(3));
+            test.execute(Write{"tac"}.with_bytes_written(1));
+            test.execute(Peek{"catt"});
+            test.execute(Pop{2});
+            test.execute(Write{"dog"}.with_bytes_written(2));
+
+            test.execute(BytesRead{2});
+            test.execute(BytesWritten{6});
+            test.execute(RemainingCapacity{0});
+            test.execute(BufferSize{4});
+            test.execute(Peek{"ttdo"});
+        }
+
+        {
+            ByteStream stream{8, true};
+            Buffer payload{string("abcdef")};
+            stream.write(payload);
+            stream.write(Buffer{string("ghij")});
+
+            const BufferList peeked = stream.peek_buffers(7);
+            if (peeked.concatenate() != "abcdefg") {
+                throw runtime_error("peek_buffers returned \"" + peeked.concatenate() + "\"");
+            }
+            if (peeked.buffers().front().str().data() != payload.str().data()) {
+                throw runtime_error("chunked ByteStream copied a Buffer that fit in full");
+            }
+
+            const BufferList read = stream.read_buffers(5);
+            if (read.concatenate() != "abcde" or stream.buffer_size() != 3 or stream.peek_output(3) != "fgh") {
+                throw runtime_error("read_buffers did not pop the bytes it returned");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -45,11 +45,11 @@ void ByteStreamAction::execute(ByteStream &) const {}
 
 ByteStreamAction::~ByteStreamAction() {}
 
-ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name, const size_t capacity)
-    : _test_name(test_name), _byte_stream(capacity) {
+ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name, const size_t capacity, const bool chunked)
+    : _test_name(test_name), _byte_stream(capacity, chunked) {
     std::ostringstream ss;
     ss << "Initialized with ("
-       << "capacity=" << capacity << ")";
+       << "capacity=" << capacity << ", chunked=" << chunked << ")";
     _steps_executed.emplace_back(ss.str());
 }
 
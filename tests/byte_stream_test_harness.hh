@@ -134,7 +134,7 @@ class ByteStreamTestHarness {
     std::vector<std::string> _steps_executed{};
 
   public:
-    ByteStreamTestHarness(const std::string &test_name, const size_t capacity);
+    ByteStreamTestHarness(const std::string &test_name, const size_t capacity, const bool chunked = false);
 
     void execute(const ByteStreamTestStep &step);
 };
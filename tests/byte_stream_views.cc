@@ -0,0 +1,67 @@
+#include "byte_stream.hh"
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/uio.h>
+#include <vector>
+
+using namespace std;
+
+static string concatenate(const BufferViewList &views) {
+    string ret;
+    for (const auto &iov : views.as_iovecs()) {
+        ret.append(static_cast<const char *>(iov.iov_base), iov.iov_len);
+    }
+    return ret;
+}
+
+static void check_views(const ByteStream &stream, const size_t len, const string &expected, const size_t n_views) {
+    const BufferViewList views = stream.peek_views(len);
+    if (concatenate(views) != expected) {
+        throw runtime_error("peek_views(" + to_string(len) + ") returned \"" + concatenate(views) +
+                            "\", expected \"" + expected + "\"");
+    }
+    if (views.as_iovecs().size() != n_views) {
+        throw runtime_error("peek_views(" + to_string(len) + ") returned " + to_string(views.as_iovecs().size()) +
+                            " views, expected " + to_string(n_views));
+    }
+}
+
+int main() {
+    try {
+        {
+            // contiguous, then wrapped around the end of the circular buffer
+            ByteStream stream{8};
+            stream.write("abcdef");
+            check_views(stream, 100, "abcdef", 1);
+            check_views(stream, 3, "abc", 1);
+
+            stream.pop_output(5);
+            stream.write("ghijkl");
+            check_views(stream, 100, "fghijkl", 2);
+            check_views(stream, 4, "fghi", 2);
+            check_views(stream, 3, "fgh", 1);
+
+            stream.pop_output(7);
+            check_views(stream, 100, "", 0);
+        }
+
+        {
+            // chunked streams return one view per stored Buffer
+            ByteStream stream{16, true};
+            stream.write("abc");
+            stream.write("defg");
+            stream.pop_output(1);
+            check_views(stream, 100, "bcdefg", 2);
+            check_views(stream, 4, "bcde", 2);
+            check_views(stream, 1, "b", 1);
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
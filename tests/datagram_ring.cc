@@ -0,0 +1,129 @@
+#include "address.hh"
+#include "datagram_ring.hh"
+#include "engine_pair.hh"
+#include "socket.hh"
+#include "tcp_config.hh"
+#include "tcp_engine.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            UDPSocket sock;
+            if (not DatagramRing::make(sock, true)) {
+                cerr << "io_uring is not available; skipping the DatagramRing tests\n";
+                return EXIT_SUCCESS;
+            }
+        }
+
+        // test 1: datagrams written through one ring are read through another, in order and in few system calls
+        {
+            int fds[2];
+            SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_DGRAM, 0, static_cast<int *>(fds)));
+            const FileDescriptor a(fds[0]), b(fds[1]);
+            DatagramRing ring_a(a, false), ring_b(b, false);
+            constexpr size_t n_datagrams = 200;
+
+            const uint64_t calls_before = system_call_count();
+            for (size_t i = 0; i < n_datagrams; ++i) {
+                ring_a.write(string(i + 1, char('a' + i % 26)));
+            }
+            ring_a.flush();
+            for (size_t i = 0; i < n_datagrams; ++i) {
+                const auto datagram = ring_b.read();
+                test_err_if(datagram != string(i + 1, char('a' + i % 26)),
+                            "test 1 failed: datagram " + to_string(i) + " wrong or missing");
+            }
+            test_err_if(ring_b.read().has_value(), "test 1 failed: extra datagram");
+            test_err_if(ring_b.datagram_waiting(), "test 1 failed: datagram waiting after the last one");
+            const uint64_t calls = system_call_count() - calls_before;
+            test_err_if(calls > n_datagrams / 8, "test 1 failed: " + to_string(calls) + " system calls");
+        }
+
+        // test 2: a UDP ring reads the source address of each datagram
+        {
+            UDPSocket sender, receiver;
+            sender.bind(Address("127.0.0.1", 0));
+            receiver.bind(Address("127.0.0.1", 0));
+            DatagramRing ring_sender(sender, true), ring_receiver(receiver, true);
+            const Address destination = receiver.local_address();
+            ring_sender.write(string("hello"), &destination);
+            ring_sender.flush();
+
+            Address source{"127.0.0.1", 0};
+            const auto datagram = ring_receiver.read(&source);
+            test_err_if(datagram != "hello", "test 2 failed: wrong payload");
+            test_err_if(source != sender.local_address(), "test 2 failed: wrong source " + source.to_string());
+        }
+
+        // test 3: a ring of depth zero is refused, as its batches would always look full
+        {
+            UDPSocket sock;
+            bool threw = false;
+            try {
+                DatagramRing ring(sock, true, 0);
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            test_err_if(not threw, "test 3 failed: depth zero accepted");
+        }
+
+        // test 4: two TCPEngines exchange data over UDP through io_uring
+        {
+            TCPConfig cfg{};
+            cfg.rt_timeout = 20;
+            constexpr uint16_t server_port = 80;
+            constexpr size_t n_connections = 64;
+            const string data(50000, 'x');
+
+            map<uint16_t, size_t> received;
+            map<uint16_t, size_t> sent;
+            EnginePair engines(
+                [&](const FourTuple &tuple, TCPConnection &connection) {
+                    ByteStream &inbound = connection.inbound_stream();
+                    received[tuple.remote_port] += inbound.read(inbound.buffer_size()).size();
+                    if (inbound.eof()) {
+                        connection.end_input_stream();
+                    }
+                },
+                [&](const FourTuple &tuple, TCPConnection &connection) {
+                    size_t &n = sent[tuple.local_port];
+                    if (n < data.size()) {
+                        n += connection.write(data.substr(n));
+                        if (n == data.size()) {
+                            connection.end_input_stream();
+                        }
+                    }
+                },
+                true);
+            engines.server.listen(cfg, server_port);
+
+            const uint32_t loopback = Address("127.0.0.1").ipv4_numeric();
+            for (size_t i = 0; i < n_connections; ++i) {
+                engines.client.connect(cfg, {loopback, uint16_t(10000 + i), loopback, server_port});
+            }
+            test_err_if(not engines.run_until_closed(20000, server_port), "test 4 failed: connections did not finish");
+            test_err_if(received.size() != n_connections, "test 4 failed: not every connection sent data");
+            for (const auto &[port, n] : received) {
+                test_err_if(n != data.size(), "test 4 failed: connection " + to_string(port) + " got " + to_string(n));
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
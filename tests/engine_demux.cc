@@ -0,0 +1,165 @@
+#include "address.hh"
+#include "engine_pair.hh"
+#include "tcp_config.hh"
+#include "tcp_engine.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t N_CONNECTIONS = 256;
+static constexpr uint16_t FIRST_CLIENT_PORT = 10000;
+static constexpr uint16_t SERVER_PORT = 80;
+
+int main() {
+    try {
+        TCPConfig cfg{};
+        cfg.rt_timeout = 20;
+
+        // test 1: one engine accepts many connections from another, and echoes what each one sends
+        {
+            const auto echo = [](const FourTuple &, TCPConnection &connection) {
+                ByteStream &inbound = connection.inbound_stream();
+                connection.write(inbound.read(min(inbound.buffer_size(), connection.remaining_outbound_capacity())));
+                if (inbound.eof() and inbound.buffer_empty()) {
+                    connection.end_input_stream();
+                }
+            };
+            map<uint16_t, string> echoed;
+            EnginePair engines(echo, [&](const FourTuple &tuple, TCPConnection &connection) {
+                ByteStream &inbound = connection.inbound_stream();
+                echoed[tuple.local_port] += inbound.read(inbound.buffer_size());
+            });
+            TCPOverUDPEngine &server = engines.server, &client = engines.client;
+            server.listen(cfg, SERVER_PORT);
+
+            const uint32_t loopback = Address("127.0.0.1").ipv4_numeric();
+            for (size_t i = 0; i < N_CONNECTIONS; ++i) {
+                const uint16_t port = FIRST_CLIENT_PORT + i;
+                TCPConnection &connection = client.connect(cfg, {loopback, port, loopback, SERVER_PORT});
+                connection.write("hello from " + to_string(port));
+                connection.end_input_stream();
+            }
+            test_err_if(client.connection_count() != N_CONNECTIONS, "test 1 failed: connections not in the table");
+
+            engines.run_until_closed(10000, SERVER_PORT);
+            test_err_if(client.connection_count() != 0, "test 1 failed: client connections did not finish");
+            test_err_if(server.connection_count() != 0, "test 1 failed: server connections did not finish");
+
+            test_err_if(server.listen_counters(SERVER_PORT).accepted != N_CONNECTIONS,
+                        "test 1 failed: not every connection was accepted");
+            test_err_if(echoed.size() != N_CONNECTIONS, "test 1 failed: not every connection got its echo");
+            for (const auto &[port, data] : echoed) {
+                test_err_if(data != "hello from " + to_string(port),
+                            "test 1 failed: connection " + to_string(port) + " got \"" + data + "\"");
+            }
+        }
+
+        // test 2: a segment that is not a SYN to a listening port does not create a connection
+        {
+            EnginePair engines([](const FourTuple &, TCPConnection &) {}, [](const FourTuple &, TCPConnection &) {});
+            TCPOverUDPEngine &server = engines.server, &client = engines.client;
+            server.listen(cfg, SERVER_PORT);
+
+            const uint32_t loopback = Address("127.0.0.1").ipv4_numeric();
+            client.connect(cfg, {loopback, FIRST_CLIENT_PORT, loopback, SERVER_PORT + 1});
+            TCPSegment stray;
+            stray.header().ack = true;
+            client.adapter().write_to({loopback, FIRST_CLIENT_PORT + 1, loopback, SERVER_PORT}, stray);
+
+            engines.run_for(100);
+            test_err_if(server.connection_count() != 0, "test 2 failed: connection created without a listener or SYN");
+        }
+
+        // test 3: a listening port keeps at most `backlog` connections in each queue, and drops
+        // further SYNs until accept() makes room; the dropped SYNs are retransmitted
+        {
+            constexpr size_t backlog = 4;
+            constexpr size_t n_connections = 16;
+            EnginePair engines([](const FourTuple &, TCPConnection &) {}, [](const FourTuple &, TCPConnection &) {});
+            TCPOverUDPEngine &server = engines.server, &client = engines.client;
+            server.listen(cfg, SERVER_PORT, backlog);
+
+            const uint32_t loopback = Address("127.0.0.1").ipv4_numeric();
+            for (size_t i = 0; i < n_connections; ++i) {
+                client.connect(cfg, {loopback, uint16_t(FIRST_CLIENT_PORT + i), loopback, SERVER_PORT});
+            }
+
+            engines.run_for(100);
+            test_err_if(server.connection_count() > 2 * backlog, "test 3 failed: backlog exceeded");
+            test_err_if(server.listen_counters(SERVER_PORT).syns_dropped == 0, "test 3 failed: no SYN dropped");
+
+            size_t accepted = 0;
+            const uint64_t deadline = timestamp_ms() + 5000;
+            while (accepted < n_connections and timestamp_ms() < deadline) {
+                accepted += engines.step(1, SERVER_PORT);
+            }
+            test_err_if(accepted != n_connections, "test 3 failed: only " + to_string(accepted) + " accepted");
+            for (size_t i = 0; i < n_connections; ++i) {
+                const TCPConnection *connection =
+                    client.find({loopback, uint16_t(FIRST_CLIENT_PORT + i), loopback, SERVER_PORT});
+                test_err_if(connection == nullptr or not connection->handshake_complete(),
+                            "test 3 failed: client connection not established");
+            }
+
+            // test 4: once the handshakes are done, the idle connections have no deadline, and
+            // waiting for events sleeps for the whole timeout
+            engines.run_for(100);
+            test_err_if(client.timer_count() != 0 or server.timer_count() != 0,
+                        "test 4 failed: idle connections have timers");
+            const uint64_t start = timestamp_ms();
+            server.wait_next_event(50);
+            test_err_if(timestamp_ms() - start < 40, "test 4 failed: woke up early");
+
+            // a write outside the handler is sent by flush(), and arms the retransmission timer
+            const FourTuple first{loopback, FIRST_CLIENT_PORT, loopback, SERVER_PORT};
+            client.find(first)->write("x");
+            client.flush(first);
+            test_err_if(client.timer_count() != 1, "test 4 failed: no retransmission timer");
+        }
+
+        // test 5: data flushed after an idle period is stamped with the current time, so its
+        // RTT sample does not include the idle time
+        {
+            TCPConfig rtt_cfg = cfg;
+            rtt_cfg.adaptive_rto = true;
+            rtt_cfg.rto_min = 1000;  // so that the idle time does not look like a timeout
+            EnginePair engines(
+                [](const FourTuple &, TCPConnection &connection) {
+                    ByteStream &inbound = connection.inbound_stream();
+                    inbound.pop_output(inbound.buffer_size());
+                },
+                [](const FourTuple &, TCPConnection &) {});
+            TCPOverUDPEngine &server = engines.server, &client = engines.client;
+            server.listen(rtt_cfg, SERVER_PORT);
+
+            const uint32_t loopback = Address("127.0.0.1").ipv4_numeric();
+            const FourTuple tuple{loopback, FIRST_CLIENT_PORT, loopback, SERVER_PORT};
+            client.connect(rtt_cfg, tuple);
+            engines.run_for(100, SERVER_PORT);
+            test_err_if(not client.find(tuple)->handshake_complete(), "test 5 failed: connection not established");
+
+            engines.run_for(400, {}, 10);
+            client.find(tuple)->write("x");
+            client.flush(tuple);
+            engines.run_for(100);
+            const TCPConnection &connection = *client.find(tuple);
+            test_err_if(connection.bytes_in_flight() != 0, "test 5 failed: data not acknowledged");
+            test_err_if(not connection.smoothed_rtt().has_value() or connection.smoothed_rtt().value() > 20,
+                        "test 5 failed: SRTT of " + to_string(connection.smoothed_rtt().value_or(0)) + " ms");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+#ifndef SPONGE_TESTS_ENGINE_PAIR_HH
+#define SPONGE_TESTS_ENGINE_PAIR_HH
+
+#include "address.hh"
+#include "socket.hh"
+#include "tcp_engine.hh"
+#include "util.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+//! a UDP adapter bound to an ephemeral port on the loopback interface, reading and writing through io_uring if asked
+inline TCPOverUDPSocketAdapter loopback_adapter(const bool io_uring = false) {
+    UDPSocket sock;
+    sock.bind(Address("127.0.0.1", 0));
+    const Address local = sock.local_address();
+    TCPOverUDPSocketAdapter adapter(std::move(sock));
+    adapter.config_mut().source = local;
+    if (io_uring and not adapter.enable_io_uring()) {
+        throw std::runtime_error("io_uring is not available");
+    }
+    return adapter;
+}
+
+//! Two TCPOverUDPEngines on the loopback interface, each tunneling to the other's UDP port, run in lock step
+class EnginePair {
+  public:
+    TCPOverUDPEngine server;  //!< The engine that listens
+    TCPOverUDPEngine client;  //!< The engine that connects
+
+    //! Construct the engines with their handlers, reading and writing through io_uring if asked
+    EnginePair(const TCPOverUDPEngine::HandlerT &server_handler,
+               const TCPOverUDPEngine::HandlerT &client_handler,
+               const bool io_uring = false)
+        : server(loopback_adapter(io_uring), server_handler), client(loopback_adapter(io_uring), client_handler) {
+        server.adapter().config_mut().destination = client.adapter().config().source;
+        client.adapter().config_mut().destination = server.adapter().config().source;
+    }
+
+    //! Let each engine handle its events, waiting up to `timeout_ms` for them, then accept the
+    //! connections waiting on `accept_port` (if given)
+    //! \returns the number of connections accepted
+    size_t step(const int timeout_ms = 1, const std::optional<uint16_t> accept_port = {}) {
+        client.wait_next_event(timeout_ms);
+        server.wait_next_event(timeout_ms);
+        size_t accepted = 0;
+        while (accept_port and server.accept(accept_port.value())) {
+            accepted++;
+        }
+        return accepted;
+    }
+
+    //! step() until `ms` have passed
+    //! \returns the number of connections accepted
+    size_t run_for(const uint64_t ms, const std::optional<uint16_t> accept_port = {}, const int timeout_ms = 1) {
+        size_t accepted = 0;
+        const uint64_t deadline = timestamp_ms() + ms;
+        while (timestamp_ms() < deadline) {
+            accepted += step(timeout_ms, accept_port);
+        }
+        return accepted;
+    }
+
+    //! step() until neither engine has a connection left, or `ms` have passed
+    //! \returns `true` if neither engine has a connection left
+    bool run_until_closed(const uint64_t ms, const std::optional<uint16_t> accept_port = {}) {
+        const uint64_t deadline = timestamp_ms() + ms;
+        while ((client.connection_count() > 0 or server.connection_count() > 0) and timestamp_ms() < deadline) {
+            step(1, accept_port);
+        }
+        return client.connection_count() == 0 and server.connection_count() == 0;
+    }
+};
+
+#endif  // SPONGE_TESTS_ENGINE_PAIR_HH
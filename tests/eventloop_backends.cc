@@ -0,0 +1,132 @@
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//! a connected pair of AF_UNIX stream sockets
+static pair<FileDescriptor, FileDescriptor> socket_pair() {
+    int fds[2];
+    SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, static_cast<int *>(fds)));
+    return {FileDescriptor(fds[0]), FileDescriptor(fds[1])};
+}
+
+static void test_backend(const EventLoop::Backend backend, const string &name) {
+    constexpr size_t n_pairs = 1000;
+
+    // test 1: only the ready fds have their callbacks called
+    {
+        EventLoop loop{backend};
+        vector<pair<FileDescriptor, FileDescriptor>> pairs;
+        vector<size_t> calls(n_pairs, 0);
+        for (size_t i = 0; i < n_pairs; ++i) {
+            pairs.push_back(socket_pair());
+            loop.add_rule(pairs.back().first, Direction::In, [&, i] {
+                pairs[i].first.read(1);
+                calls[i]++;
+            });
+        }
+
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, name + " test 1 failed: no timeout");
+        for (size_t i = 0; i < n_pairs; i += 10) {
+            pairs[i].second.write("x");
+        }
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, name + " test 1 failed: no event");
+        for (size_t i = 0; i < n_pairs; ++i) {
+            test_err_if(calls[i] != (i % 10 == 0 ? 1 : 0), name + " test 1 failed: wrong callbacks");
+        }
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, name + " test 1 failed: event after read");
+    }
+
+    // test 2: an fd is only polled while its rule is interested
+    {
+        EventLoop loop{backend};
+        auto [a, b] = socket_pair();
+        bool interested = false;
+        size_t in_calls = 0, out_calls = 0;
+        loop.add_rule(a, Direction::In, [&] {
+            a.read(1);
+            in_calls++;
+        });
+        loop.add_rule(
+            a,
+            Direction::Out,
+            [&] {
+                a.write("y");
+                out_calls++;
+                interested = false;
+            },
+            [&] { return interested; });
+
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, name + " test 2 failed: uninterested");
+        interested = true;
+        b.write("x");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, name + " test 2 failed: no event");
+        test_err_if(in_calls != 1 or out_calls != 1, name + " test 2 failed: both rules of the fd not called");
+        test_err_if(b.read(1) != "y", name + " test 2 failed: write not done");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, name + " test 2 failed: interest kept");
+    }
+
+    // test 3: a rule is canceled at EOF, and the loop exits when no rules are left
+    {
+        EventLoop loop{backend};
+        auto [a, b] = socket_pair();
+        bool canceled = false;
+        loop.add_rule(
+            a, Direction::In, [&] { a.read(); }, {}, [&] { canceled = true; });
+        b.close();
+        loop.wait_next_event(0);
+        loop.wait_next_event(0);
+        test_err_if(not canceled, name + " test 3 failed: rule not canceled at EOF");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, name + " test 3 failed: no exit");
+    }
+
+    // test 4: a callback that neither reads nor loses interest is a busy wait
+    {
+        EventLoop loop{backend};
+        auto [a, b] = socket_pair();
+        loop.add_rule(a, Direction::In, [] {});
+        b.write("x");
+        bool thrown = false;
+        try {
+            loop.wait_next_event(0);
+        } catch (const runtime_error &) {
+            thrown = true;
+        }
+        test_err_if(not thrown, name + " test 4 failed: busy wait not detected");
+    }
+
+    // test 5: a rule is canceled when its fd is closed elsewhere, even without an interest callback
+    {
+        EventLoop loop{backend};
+        auto [a, b] = socket_pair();
+        bool canceled = false;
+        loop.add_rule(
+            a, Direction::In, [&] { a.read(); }, {}, [&] { canceled = true; });
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, name + " test 5 failed: no timeout");
+        a.close();
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, name + " test 5 failed: no exit");
+        test_err_if(not canceled, name + " test 5 failed: rule not canceled at closure");
+    }
+}
+
+int main() {
+    try {
+        test_backend(EventLoop::Backend::Poll, "poll");
+        test_backend(EventLoop::Backend::Epoll, "epoll");
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
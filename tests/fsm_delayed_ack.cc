@@ -0,0 +1,160 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+//! a segment from the peer carrying `data`
+static TCPSegment data_segment(const WrappingInt32 seqno, const WrappingInt32 ackno, const string &data) {
+    TCPSegment seg;
+    seg.header().ack = true;
+    seg.header().seqno = seqno;
+    seg.header().ackno = ackno;
+    seg.header().win = 1000;
+    seg.payload() = string(data);
+    return seg;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        TCPConfig cfg{};
+        cfg.ack_delay = 200;
+
+        // test 1: in-order data is acked after the delay, or at every second full-sized segment
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_1.execute(SendSegment{}.with_ack(true).with_seqno(rx_isn + 1).with_ackno(tx_isn + 1).with_data("a"));
+            test_1.execute(Tick(199));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: ACK not delayed");
+            test_1.execute(Tick(1));
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 2).with_payload_size(0),
+                           "test 1 failed: delayed ACK not sent");
+
+            test_1.execute(
+                SendSegment{}.with_ack(true).with_seqno(rx_isn + 2).with_ackno(tx_isn + 1).with_data(string(mss, 'b')));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: ACK of one full segment not delayed");
+            test_1.execute(SendSegment{}.with_ack(true).with_seqno(rx_isn + 2 + mss).with_ackno(tx_isn + 1).with_data(
+                string(mss, 'c')));
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 2 + 2 * mss).with_payload_size(0),
+                           "test 1 failed: second full segment not acked at once");
+            test_1.execute(Tick(200));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: extra ACK after the delay");
+        }
+
+        // test 2: out-of-order data and filled holes are acked at once, data carries a pending ACK
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_2.execute(SendSegment{}.with_ack(true).with_seqno(rx_isn + 3).with_ackno(tx_isn + 1).with_data("c"));
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1).with_payload_size(0),
+                           "test 2 failed: out-of-order segment not acked at once");
+            test_2.execute(SendSegment{}.with_ack(true).with_seqno(rx_isn + 1).with_ackno(tx_isn + 1).with_data("ab"));
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 4).with_payload_size(0),
+                           "test 2 failed: filled hole not acked at once");
+
+            test_2.execute(SendSegment{}.with_ack(true).with_seqno(rx_isn + 4).with_ackno(tx_isn + 1).with_data("d"));
+            test_2.execute(ExpectNoSegment{});
+            test_2.execute(Write{"hello"});
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 5).with_data("hello"),
+                           "test 2 failed: data does not carry the pending ACK");
+            test_2.execute(Tick(200));
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: ACK sent although data carried it");
+
+            test_2.execute(SendSegment{}.with_ack(true).with_fin(true).with_seqno(rx_isn + 5).with_ackno(tx_isn + 6));
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 6), "test 2 failed: FIN not acked");
+            test_2.execute(ExpectState{State::CLOSE_WAIT});
+        }
+
+        // test 3: acks that advance the ackno are coalesced while segments_out() is not drained
+        {
+            TCPConfig c{};
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            c.fixed_isn = tx_isn;
+            TCPConnection conn{c};
+            conn.connect();
+            conn.segments_out().pop();
+
+            TCPSegment syn = data_segment(rx_isn, tx_isn + 1, "");
+            syn.header().syn = true;
+            conn.segment_received(syn);
+            test_err_if(conn.segments_out().size() != 1, "test 3 failed: SYN not acked");
+            conn.segments_out().pop();
+
+            for (uint32_t i = 0; i < 4; i++) {
+                conn.segment_received(data_segment(rx_isn + 1 + i, tx_isn + 1, "x"));
+            }
+            test_err_if(conn.segments_out().size() != 1, "test 3 failed: ACKs not coalesced");
+            test_err_if(conn.segments_out().front().header().ackno != rx_isn + 5, "test 3 failed: wrong ackno");
+            conn.segments_out().pop();
+
+            // duplicate acks are not coalesced
+            conn.segment_received(data_segment(rx_isn + 7, tx_isn + 1, "y"));
+            conn.segment_received(data_segment(rx_isn + 8, tx_isn + 1, "z"));
+            test_err_if(conn.segments_out().size() != 2, "test 3 failed: duplicate ACKs coalesced");
+
+            const auto &counters = conn.ack_counters();
+            test_err_if(counters.segments_to_ack != 7 or counters.pure_acks_sent != 4 or counters.coalesced != 3,
+                        "test 3 failed: wrong ack counters");
+        }
+
+        // test 4: a burst passed to segments_received() gets one ACK, but duplicate ACKs are kept
+        {
+            TCPConfig c{};
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            c.fixed_isn = tx_isn;
+            TCPConnection conn{c};
+            conn.connect();
+            conn.segments_out().pop();
+
+            TCPSegment syn = data_segment(rx_isn, tx_isn + 1, "");
+            syn.header().syn = true;
+            conn.segments_received({syn});
+            test_err_if(conn.segments_out().size() != 1, "test 4 failed: SYN not acked");
+            conn.segments_out().pop();
+
+            vector<TCPSegment> burst;
+            for (uint32_t i = 0; i < 4; i++) {
+                burst.push_back(data_segment(rx_isn + 1 + i, tx_isn + 1, "x"));
+            }
+            conn.segments_received(burst);
+            test_err_if(conn.segments_out().size() != 1, "test 4 failed: burst not acked once");
+            test_err_if(conn.segments_out().front().header().ackno != rx_isn + 5, "test 4 failed: wrong ackno");
+            test_err_if(conn.segments_out().front().header().win != c.recv_capacity - 4, "test 4 failed: wrong window");
+            conn.segments_out().pop();
+
+            conn.segments_received({data_segment(rx_isn + 7, tx_isn + 1, "y"),
+                                    data_segment(rx_isn + 8, tx_isn + 1, "z"),
+                                    data_segment(rx_isn + 5, tx_isn + 1, "ab")});
+            // the second duplicate ACK is superseded by the ACK of the filled hole
+            test_err_if(conn.segments_out().size() != 2, "test 4 failed: duplicate ACK not kept");
+            test_err_if(conn.segments_out().front().header().ackno != rx_isn + 5, "test 4 failed: wrong ackno");
+            conn.segments_out().pop();
+            test_err_if(conn.segments_out().front().header().ackno != rx_isn + 9, "test 4 failed: hole not acked");
+            test_err_if(conn.inbound_stream().read(8) != "xxxxabyz", "test 4 failed: wrong data");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
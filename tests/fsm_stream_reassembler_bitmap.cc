@@ -0,0 +1,78 @@
+#include "byte_stream.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static constexpr unsigned NREPS = 64;
+static constexpr unsigned NPUSHES = 512;
+
+// The bitmap storage must behave exactly like the segment storage
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        for (const size_t capacity : {1, 7, 64, 65, 1000, 4096}) {
+            for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+                const size_t stream_len = 1 + rd() % (4 * capacity);
+                string d(stream_len, 0);
+                generate(d.begin(), d.end(), [&] { return rd(); });
+
+                StreamReassembler segments{capacity, StreamReassembler::Storage::Segments};
+                StreamReassembler bitmap{capacity, StreamReassembler::Storage::Bitmap};
+
+                for (unsigned i = 0; i < NPUSHES and not segments.stream_out().eof(); ++i) {
+                    // a random substring near the head of the window, possibly overlapping stored bytes
+                    const size_t head = segments.stream_out().bytes_written();
+                    const size_t index = min(stream_len, head - min(head, rd() % 8) + rd() % (capacity + 1));
+                    const size_t len = min(stream_len - index, size_t(rd() % (capacity / 2 + 2)));
+                    const bool eof = index + len == stream_len;
+
+                    segments.push_substring(d.substr(index, len), index, eof);
+                    bitmap.push_substring(d.substr(index, len), index, eof);
+
+                    if (segments.unassembled_bytes() != bitmap.unassembled_bytes() or
+                        segments.empty() != bitmap.empty()) {
+                        throw runtime_error("unassembled bytes differ: " + to_string(segments.unassembled_bytes()) +
+                                            " vs " + to_string(bitmap.unassembled_bytes()));
+                    }
+                    const auto ranges = segments.unassembled_ranges();
+                    if (ranges != bitmap.unassembled_ranges()) {
+                        throw runtime_error("unassembled ranges differ");
+                    }
+                    size_t range_bytes = 0;
+                    for (const auto &[start, end] : ranges) {
+                        range_bytes += end - start;
+                    }
+                    if (range_bytes != segments.unassembled_bytes()) {
+                        throw runtime_error("unassembled ranges do not cover the unassembled bytes");
+                    }
+                    if (segments.stream_out().bytes_written() != bitmap.stream_out().bytes_written() or
+                        segments.stream_out().input_ended() != bitmap.stream_out().input_ended()) {
+                        throw runtime_error("assembled bytes differ");
+                    }
+
+                    const size_t to_read = rd() % (segments.stream_out().buffer_size() + 1);
+                    const size_t offset = segments.stream_out().bytes_read();
+                    const string expected = d.substr(offset, to_read);
+                    if (segments.stream_out().read(to_read) != expected or bitmap.stream_out().read(to_read) != expected) {
+                        throw runtime_error("content of RX bytes is incorrect");
+                    }
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.window_scaling = true;
+        cfg.recv_capacity = 1000000;
+        cfg.send_capacity = 1000000;
+
+        // test 1: both SYNs offer window scaling, windows beyond 64 KiB are advertised and used
+        {
+            const WrappingInt32 seq_base(rd());
+            TCPTestHarness test_1(cfg);
+
+            test_1.execute(Listen{});
+            test_1.execute(SendSegment{}.with_syn(true).with_seqno(seq_base).with_win(65535).with_window_scale(3));
+
+            TCPSegment seg = test_1.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(seq_base + 1).with_win(65535),
+                "test 1 failed: SYN/ACK invalid");
+            test_err_if(seg.header().window_scale != 4, "test 1 failed: SYN/ACK should offer a window scale of 4");
+            const WrappingInt32 ack_base = seg.header().seqno;
+
+            // the peer's window of 2000 is scaled by 2^3
+            test_1.send_ack(seq_base + 1, ack_base + 1, 2000);
+            test_1.execute(ExpectState{State::ESTABLISHED});
+            test_1.execute(Write{string(100000, 'x')}.with_bytes_written(100000));
+            test_1.execute(ExpectBytesInFlight{16000}, "test 1 failed: scaled send window not used");
+            while (test_1.can_read()) {
+                test_1.expect_seg(ExpectSegment{}.with_ackno(seq_base + 1).with_win(1000000 >> 4));
+            }
+
+            // our window is advertised with a shift of 4
+            test_1.execute(SendSegment{}.with_ack(true).with_seqno(seq_base + 1).with_ackno(ack_base + 1).with_win(
+                2000).with_data(string(100, 'y')));
+            test_1.expect_seg(ExpectSegment{}.with_ackno(seq_base + 101).with_win((1000000 - 100) >> 4),
+                              "test 1 failed: advertised window not scaled");
+        }
+
+        // test 2: the peer does not offer window scaling, windows are neither scaled nor offered
+        {
+            const WrappingInt32 seq_base(rd());
+            TCPTestHarness test_2(cfg);
+
+            test_2.execute(Listen{});
+            test_2.send_syn(seq_base);
+
+            TCPSegment seg = test_2.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(seq_base + 1).with_win(65535),
+                "test 2 failed: SYN/ACK invalid");
+            test_err_if(seg.header().window_scale.has_value(), "test 2 failed: SYN/ACK offered window scaling");
+            const WrappingInt32 ack_base = seg.header().seqno;
+
+            test_2.send_ack(seq_base + 1, ack_base + 1, 2000);
+            test_2.execute(Write{string(100000, 'x')}.with_bytes_written(100000));
+            test_2.execute(ExpectBytesInFlight{2000}, "test 2 failed: unscaled send window not respected");
+        }
+
+        // test 3: active open offers window scaling, the SYN/ACK without it turns it off
+        {
+            const WrappingInt32 seq_base(rd());
+            TCPTestHarness test_3(cfg);
+
+            test_3.execute(Connect{});
+            TCPSegment seg = test_3.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(false).with_win(65535),
+                                               "test 3 failed: SYN invalid");
+            test_err_if(seg.header().window_scale != 4, "test 3 failed: SYN should offer a window scale of 4");
+            const WrappingInt32 ack_base = seg.header().seqno;
+
+            test_3.send_syn(seq_base, ack_base + 1);
+            test_3.execute(ExpectState{State::ESTABLISHED});
+            test_3.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(seq_base + 1).with_win(65535),
+                              "test 3 failed: ACK invalid");
+            test_3.send_ack(seq_base + 1, ack_base + 1, 1000);
+            test_3.execute(Write{string(5000, 'x')}.with_bytes_written(5000));
+            test_3.execute(ExpectBytesInFlight{1000}, "test 3 failed: unscaled send window not respected");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -13,6 +13,8 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 struct ReceiverTestStep {
     virtual std::string to_string() const { return "ReceiverTestStep"; }
@@ -100,6 +102,56 @@ struct ExpectUnassembledBytes : public ReceiverExpectation {
     }
 };
 
+struct ExpectSackBlocks : public ReceiverExpectation {
+    std::vector<std::pair<WrappingInt32, WrappingInt32>> _blocks;
+
+    ExpectSackBlocks(std::vector<std::pair<WrappingInt32, WrappingInt32>> blocks) : _blocks(std::move(blocks)) {}
+    std::string description() const {
+        std::ostringstream ss;
+        ss << "SACK blocks";
+        for (const auto &[left, right] : _blocks) {
+            ss << " " << left << "-" << right;
+        }
+        return ss.str();
+    }
+
+    void execute(TCPReceiver &receiver) const {
+        const auto blocks = receiver.sack_blocks(TCPHeader::MAX_SACK_BLOCKS);
+        if (blocks != _blocks) {
+            std::ostringstream ss;
+            ss << "The TCPReceiver reported SACK blocks";
+            for (const auto &[left, right] : blocks) {
+                ss << " " << left << "-" << right;
+            }
+            ss << ", but " << description() << " were expected";
+            throw ReceiverExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct ExpectTimestampEcho : public ReceiverExpectation {
+    std::optional<uint32_t> _echo;
+
+    ExpectTimestampEcho(std::optional<uint32_t> echo) : _echo(echo) {}
+    std::string description() const {
+        if (_echo.has_value()) {
+            return "timestamp echo " + std::to_string(_echo.value());
+        } else {
+            return "no timestamp echo";
+        }
+    }
+
+    void execute(TCPReceiver &receiver) const {
+        if (receiver.timestamp_echo() != _echo) {
+            std::string reported = receiver.timestamp_echo().has_value()
+                                       ? std::to_string(receiver.timestamp_echo().value())
+                                       : std::string("none");
+            throw ReceiverExpectationViolation("The TCPReceiver reported timestamp echo " + reported + ", but " +
+                                               description() + " was expected");
+        }
+    }
+};
+
 struct ExpectTotalAssembledBytes : public ReceiverExpectation {
     size_t _n_bytes;
 
@@ -196,6 +248,7 @@ struct SegmentArrives : public ReceiverAction {
     WrappingInt32 ackno{0};
     uint16_t win{};
     std::string data{};
+    std::optional<std::pair<uint32_t, uint32_t>> timestamps{};
     std::optional<Result> result{};
 
     SegmentArrives &with_ack(WrappingInt32 ackno_) {
@@ -238,6 +291,11 @@ struct SegmentArrives : public ReceiverAction {
         return *this;
     }
 
+    SegmentArrives &with_timestamps(uint32_t tsval, uint32_t tsecr) {
+        timestamps.emplace(tsval, tsecr);
+        return *this;
+    }
+
     SegmentArrives &with_result(Result result_) {
         result = result_;
         return *this;
@@ -253,6 +311,7 @@ struct SegmentArrives : public ReceiverAction {
         seg.header().ackno = ackno;
         seg.header().seqno = seqno;
         seg.header().win = win;
+        seg.header().timestamps = timestamps;
         return seg;
     }
 
@@ -298,7 +357,9 @@ class TCPReceiverTestHarness {
     std::vector<std::string> steps_executed;
 
   public:
-    TCPReceiverTestHarness(size_t capacity) : receiver(capacity), steps_executed() {
+    TCPReceiverTestHarness(size_t capacity,
+                           StreamReassembler::Storage storage = StreamReassembler::Storage::Segments)
+        : receiver(capacity, storage), steps_executed() {
         std::ostringstream ss;
         ss << "Initialized with ("
            << "capacity=" << capacity << ")";
@@ -0,0 +1,90 @@
+#include "receiver_harness.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            uint32_t isn = uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd);
+            TCPReceiverTestHarness test{4000};
+            test.execute(ExpectTimestampEcho{nullopt});
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_timestamps(100, 0).with_result(
+                SegmentArrives::Result::OK));
+            test.execute(ExpectTimestampEcho{100});
+
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("abc").with_timestamps(200, 0));
+            test.execute(ExpectAckno{WrappingInt32{isn + 4}});
+            test.execute(ExpectTimestampEcho{200});
+
+            // an out-of-order segment is kept but its timestamp is not echoed
+            test.execute(SegmentArrives{}.with_seqno(isn + 7).with_data("ghi").with_timestamps(300, 0));
+            test.execute(ExpectUnassembledBytes{3});
+            test.execute(ExpectTimestampEcho{200});
+
+            // PAWS: an old duplicate is dropped, even though it fits in the window
+            test.execute(SegmentArrives{}.with_seqno(isn + 4).with_data("def").with_timestamps(150, 0));
+            test.execute(ExpectAckno{WrappingInt32{isn + 4}});
+            test.execute(ExpectTimestampEcho{200});
+
+            test.execute(SegmentArrives{}.with_seqno(isn + 4).with_data("def").with_timestamps(300, 0));
+            test.execute(ExpectAckno{WrappingInt32{isn + 10}});
+            test.execute(ExpectBytes{"abcdefghi"});
+            test.execute(ExpectTimestampEcho{300});
+
+            // segments without timestamps are not checked
+            test.execute(SegmentArrives{}.with_seqno(isn + 10).with_data("j"));
+            test.execute(ExpectAckno{WrappingInt32{isn + 11}});
+        }
+
+        {
+            uint32_t isn = uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd);
+            TCPReceiverTestHarness test{4000};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_timestamps(UINT32_MAX - 10, 0));
+
+            // timestamps are compared modulo 2^32
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("abc").with_timestamps(5, 0));
+            test.execute(ExpectAckno{WrappingInt32{isn + 4}});
+            test.execute(ExpectTimestampEcho{5});
+            test.execute(SegmentArrives{}.with_seqno(isn + 4).with_data("def").with_timestamps(UINT32_MAX - 5, 0));
+            test.execute(ExpectAckno{WrappingInt32{isn + 4}});
+        }
+
+        // the timestamps option survives serializing and parsing, and leaves room for three SACK blocks
+        {
+            TCPSegment seg;
+            seg.header().timestamps.emplace(123456789, 987654321);
+            for (uint32_t i = 0; i < TCPHeader::MAX_SACK_BLOCKS; i++) {
+                seg.header().sack.emplace_back(WrappingInt32{100 * i}, WrappingInt32{100 * i + 50});
+            }
+            seg.payload() = string("hello");
+
+            TCPSegment parsed;
+            if (parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError) {
+                throw runtime_error("could not parse a segment with the timestamps option");
+            }
+            if (parsed.header().timestamps != seg.header().timestamps or
+                parsed.header().sack.size() != TCPHeader::MAX_SACK_BLOCKS_WITH_TIMESTAMPS or
+                parsed.payload().str() != "hello") {
+                throw runtime_error("timestamps option changed by serializing and parsing");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
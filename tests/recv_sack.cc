@@ -0,0 +1,101 @@
+#include "receiver_harness.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        for (const auto storage : {StreamReassembler::Storage::Segments, StreamReassembler::Storage::Bitmap}) {
+            uint32_t isn = uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd);
+            TCPReceiverTestHarness test{4000, storage};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{}});
+
+            test.execute(SegmentArrives{}.with_seqno(isn + 11).with_data("abcd"));
+            test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 11}, WrappingInt32{isn + 15}}}});
+
+            // the most recent block comes first, the others from the highest down
+            test.execute(SegmentArrives{}.with_seqno(isn + 31).with_data("efgh"));
+            test.execute(SegmentArrives{}.with_seqno(isn + 21).with_data("ijkl"));
+            test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 21}, WrappingInt32{isn + 25}},
+                                           {WrappingInt32{isn + 31}, WrappingInt32{isn + 35}},
+                                           {WrappingInt32{isn + 11}, WrappingInt32{isn + 15}}}});
+
+            // adjacent ranges are reported as one block
+            test.execute(SegmentArrives{}.with_seqno(isn + 15).with_data("mnopqr"));
+            test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 11}, WrappingInt32{isn + 25}},
+                                           {WrappingInt32{isn + 31}, WrappingInt32{isn + 35}}}});
+
+            // at most MAX_SACK_BLOCKS blocks
+            for (uint32_t i = 0; i < 5; i++) {
+                test.execute(SegmentArrives{}.with_seqno(isn + 41 + 10 * i).with_data("s"));
+            }
+            test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 81}, WrappingInt32{isn + 82}},
+                                           {WrappingInt32{isn + 71}, WrappingInt32{isn + 72}},
+                                           {WrappingInt32{isn + 61}, WrappingInt32{isn + 62}},
+                                           {WrappingInt32{isn + 51}, WrappingInt32{isn + 52}}}});
+
+            // filling the holes removes the blocks
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data(string(100, 'x')));
+            test.execute(ExpectAckno{WrappingInt32{isn + 101}});
+            test.execute(ExpectSackBlocks{{}});
+        }
+
+        // SACK options survive serializing and parsing
+        {
+            TCPSegment seg;
+            seg.header().syn = true;
+            seg.header().sack_permitted = true;
+            seg.header().sack = {{WrappingInt32{100}, WrappingInt32{200}}, {WrappingInt32{300}, WrappingInt32{400}}};
+            seg.payload() = string("hello");
+
+            TCPSegment parsed;
+            if (parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError) {
+                throw runtime_error("could not parse a segment with SACK options");
+            }
+            if (not parsed.header().sack_permitted or parsed.header().sack != seg.header().sack or
+                parsed.payload().str() != "hello") {
+                throw runtime_error("SACK options changed by serializing and parsing");
+            }
+        }
+
+        // unknown options (MSS) are skipped
+        {
+            TCPSegment seg;
+            seg.payload() = string("data");
+            string raw = seg.serialize().concatenate();
+            // MSS (kind 2), window scale (kind 3) and a NOP, then a SACK block
+            const string options = string("\x02\x04\x05\xb4\x03\x03\x07\x01\x01\x01\x05\x0a", 12) +
+                                   string("\x00\x00\x00\x0a\x00\x00\x00\x14", 8);
+            raw.insert(TCPHeader::LENGTH, options);
+            raw[12] = static_cast<char>((TCPHeader::LENGTH + options.size()) / 4 << 4);
+
+            TCPSegment parsed;
+            NetParser p{Buffer{string(raw)}};
+            parsed.header().parse(p);
+            if (p.error() or parsed.header().window_scale != 7 or parsed.header().sack_permitted or
+                parsed.header().sack.size() != 1 or
+                parsed.header().sack[0] != make_pair(WrappingInt32{10}, WrappingInt32{20}) or
+                p.buffer().str() != "data") {
+                throw runtime_error("unknown options were not skipped");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,61 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        for (const auto congestion : {TCPConfig::Congestion::Reno, TCPConfig::Congestion::Cubic}) {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const size_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+            cfg.congestion = congestion;
+
+            TCPSenderTestHarness test{"Congestion window limits the sender and shrinks on timeout", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(10000, 'a')});
+
+            // initial window is three segments
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 2 * mss));
+            test.execute(ExpectNoSegment{});
+
+            // slow start: each ack grows the window by one segment
+            test.execute(AckReceived{WrappingInt32{isn + 1 + uint32_t(mss)}}.with_win(60000));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 3 * mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 4 * mss));
+            test.execute(ExpectNoSegment{});
+
+            // a timeout retransmits and collapses the window to one segment
+            test.execute(Tick{rto});
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + mss));
+            test.execute(ExpectNoSegment{});
+
+            // everything acked: the window has grown back to two segments
+            test.execute(AckReceived{WrappingInt32{isn + 1 + uint32_t(5 * mss)}}.with_win(60000));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 5 * mss));
+            test.execute(ExpectSegment{}.with_payload_size(10000 - 6 * mss).with_seqno(isn + 1 + 6 * mss));
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const uint32_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"Third duplicate ack retransmits, partial acks retransmit the next hole", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(4 * mss, 'a')});
+            for (uint32_t i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(60000));
+            test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(60000));
+            test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(60000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(60000));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + mss));
+            test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(60000));
+            test.execute(ExpectNoSegment{});
+
+            // partial ack: the second segment was retransmitted, the third one is lost too
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 2 * mss}}.with_win(60000));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 2 * mss));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 4 * mss}}.with_win(60000));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"Acks in data segments and window updates are not duplicate acks", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(2 * mss, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + mss));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(50000));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(40000));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(30000));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+            cfg.congestion = TCPConfig::Congestion::Reno;
+
+            TCPSenderTestHarness test{"Fast recovery inflates and deflates the congestion window", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(10 * mss, 'a')});
+            for (uint32_t i = 0; i < 3; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(60000));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 3 * mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 4 * mss));
+            test.execute(ExpectNoSegment{});
+
+            // four segments in flight: ssthresh = 2 segments, cwnd = 5 segments, leaving room for one more
+            for (int i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(60000));
+            }
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 5 * mss));
+            test.execute(ExpectNoSegment{});
+
+            // each further duplicate ack lets one more segment out
+            test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(60000));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 6 * mss));
+            test.execute(ExpectNoSegment{});
+
+            // the recovery point is acked: cwnd deflates to ssthresh, which is already in flight
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 5 * mss}}.with_win(60000));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{2 * mss});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
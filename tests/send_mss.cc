@@ -0,0 +1,102 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.mss = 100;
+
+            TCPSenderTestHarness test{"Configured MSS limits payload", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{string(250, 'a')}.with_end_input(true));
+            test.execute(ExpectSegment{}.with_payload_size(100).with_seqno(isn + 1).with_fin(false));
+            test.execute(ExpectSegment{}.with_payload_size(100).with_seqno(isn + 101).with_fin(false));
+            test.execute(ExpectSegment{}.with_payload_size(50).with_seqno(isn + 201).with_fin(true));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            // a super-segment is produced whole and split into mss-sized segments by the adapter
+            WrappingInt32 isn(rd());
+            TCPSender sender{TCPConfig::DEFAULT_CAPACITY, TCPConfig::TIMEOUT_DFLT, isn, 16 * 1024};
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.ack_received(isn + 1, 20000);
+
+            string data(10000, 'x');
+            for (auto &ch : data) {
+                ch = static_cast<char>(rd());
+            }
+            sender.stream_in().write(data);
+            sender.stream_in().end_input();
+            sender.fill_window();
+            if (sender.segments_out().size() != 1) {
+                throw runtime_error("super-segment mode produced " + to_string(sender.segments_out().size()) +
+                                    " segments");
+            }
+            TCPSegment seg = sender.segments_out().front();
+            if (seg.payload().size() != data.size() or not seg.header().fin) {
+                throw runtime_error("super-segment does not hold the whole stream");
+            }
+
+            string reassembled;
+            WrappingInt32 expected_seqno = isn + 1;
+            size_t pieces = 0;
+            while (seg.payload().size() > TCPConfig::MAX_PAYLOAD_SIZE) {
+                const TCPSegment front = seg.split_front(TCPConfig::MAX_PAYLOAD_SIZE);
+                if (front.header().seqno != expected_seqno or front.header().fin or
+                    front.payload().size() != TCPConfig::MAX_PAYLOAD_SIZE) {
+                    throw runtime_error("bad piece of a split super-segment");
+                }
+                expected_seqno = expected_seqno + front.length_in_sequence_space();
+                reassembled.append(front.payload().str());
+                pieces++;
+            }
+            if (seg.header().seqno != expected_seqno or not seg.header().fin) {
+                throw runtime_error("bad last piece of a split super-segment");
+            }
+            reassembled.append(seg.payload().str());
+            pieces++;
+            const size_t expected_pieces = (data.size() + TCPConfig::MAX_PAYLOAD_SIZE - 1) / TCPConfig::MAX_PAYLOAD_SIZE;
+            if (reassembled != data or pieces != expected_pieces) {
+                throw runtime_error("split super-segment does not match the stream");
+            }
+        }
+
+        {
+            // an mss of zero would make fill_window() send empty segments for ever
+            TCPConfig cfg;
+            cfg.mss = 0;
+            bool threw = false;
+            try {
+                TCPSender sender{cfg};
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            if (not threw) {
+                throw runtime_error("TCPSender accepted an mss of zero");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.nagle = true;
+
+            TCPSenderTestHarness test{"Nagle: small writes wait while data is in flight", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{"a"});
+            test.execute(ExpectSegment{}.with_data("a").with_seqno(isn + 1));
+            test.execute(WriteBytes{"b"});
+            test.execute(WriteBytes{"c"});
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_win(10000));
+            test.execute(ExpectSegment{}.with_data("bc").with_seqno(isn + 2));
+
+            // a full segment is sent at once, the rest waits
+            test.execute(WriteBytes{string(mss + 10, 'd')});
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 4));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(10000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 4 + mss}}.with_win(10000));
+            test.execute(ExpectSegment{}.with_payload_size(10).with_seqno(isn + 4 + mss));
+
+            // the end of the stream is not held back
+            test.execute(WriteBytes{"e"}.with_end_input(true));
+            test.execute(ExpectSegment{}.with_data("e").with_seqno(isn + 14 + mss).with_fin(true));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Cork: small writes wait until uncorked", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(SetCorked{true});
+            test.execute(WriteBytes{"a"});
+            test.execute(WriteBytes{"b"});
+            test.execute(ExpectNoSegment{});
+            test.execute(WriteBytes{string(mss, 'c')});
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(SetCorked{false});
+            test.execute(ExpectSegment{}.with_payload_size(2).with_seqno(isn + 1 + mss));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.nagle = true;
+            cfg.mss = 100;
+            cfg.super_segment_size = 400;
+
+            TCPSenderTestHarness test{"Nagle: a super-segment sends whole MSS-sized segments only", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{"a"});
+            test.execute(ExpectSegment{}.with_data("a").with_seqno(isn + 1));
+
+            // less than a super-segment but more than an MSS: the whole segments go, the rest waits
+            test.execute(WriteBytes{string(250, 'b')});
+            test.execute(ExpectSegment{}.with_payload_size(200).with_seqno(isn + 2));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 202}}.with_win(10000));
+            test.execute(ExpectSegment{}.with_payload_size(50).with_seqno(isn + 202));
+
+            // a whole super-segment is not held back
+            test.execute(AckReceived{WrappingInt32{isn + 252}}.with_win(10000));
+            test.execute(WriteBytes{string(50, 'c')});
+            test.execute(ExpectSegment{}.with_payload_size(50).with_seqno(isn + 252));
+            test.execute(WriteBytes{string(400, 'd')});
+            test.execute(ExpectSegment{}.with_payload_size(400).with_seqno(isn + 302));
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.pacing = true;
+
+            TCPSenderTestHarness test{"Pacing spreads a window of segments over the RTT", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            // SRTT = 100 ms, so 1.2 * 60000 / 100 = 720 bytes per ms
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(10 * mss, 'x')});
+            test.execute(ExpectNoSegment{});
+            for (size_t i = 0; i < 5; i++) {
+                test.execute(Tick{1});
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 2 * i * mss));
+                test.execute(Tick{1});
+                test.execute(ExpectNoSegment{});
+                test.execute(Tick{1});
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + (2 * i + 1) * mss));
+                test.execute(Tick{1});
+                test.execute(ExpectNoSegment{});
+            }
+            test.execute(ExpectBytesInFlight{10 * mss});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.pacing = true;
+
+            TCPSenderTestHarness test{"An idle sender saves up at most two segments", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(Tick{1000});
+            test.execute(WriteBytes{string(10 * mss, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + mss));
+            test.execute(ExpectNoSegment{});
+            // a long tick lets its own share go
+            test.execute(Tick{10});
+            for (size_t i = 2; i < 7; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.pacing = true;
+
+            TCPSenderTestHarness test{"Without an RTT measurement, segments are not paced", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(3 * mss, 'x')});
+            for (size_t i = 0; i < 3; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.pacing = true;
+
+            TCPSenderTestHarness test{"A zero-window probe is not paced", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(0));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_payload_size(1).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            // the window opens: pacing goes on at no less than one segment per RTT
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_win(1));
+            test.execute(Tick{100});
+            test.execute(ExpectSegment{}.with_payload_size(1).with_seqno(isn + 2));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 1000;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 10;
+
+            TCPSenderTestHarness test{"RTO follows the measured RTT (RFC 6298)", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            // SRTT = 50, RTTVAR = 25, RTO = 50 + 4 * 25
+            test.execute(Tick{50});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 1));
+            test.execute(Tick{149});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 1));
+
+            // Karn's rule: the ack of a retransmitted segment gives no sample, the RTO stays 150
+            test.execute(Tick{20});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 4));
+            test.execute(Tick{149});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 4));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 1000;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 100;
+            cfg.rto_max = 300;
+
+            TCPSenderTestHarness test{"RTO is clamped to rto_min and rto_max", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            // the initial RTO is clamped to rto_max
+            test.execute(Tick{299});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            // backing off stays at rto_max
+            test.execute(Tick{299});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+
+            // a 2 ms RTT would give an RTO of 6 ms, clamped to rto_min
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 1));
+            test.execute(Tick{2});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 4));
+            test.execute(Tick{99});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 4));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,64 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const uint32_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"In fast recovery, SACK blocks let every duplicate ack repair a hole", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(8 * mss, 'a')});
+            for (uint32_t i = 0; i < 8; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+
+            // segments 0, 2 and 4 are lost
+            const WrappingInt32 base = isn + 1;
+            test.execute(AckReceived{base}.with_win(60000).with_sack(base + mss, base + 2 * mss));
+            test.execute(AckReceived{base}.with_win(60000).with_sack(base + 3 * mss, base + 4 * mss));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{base}.with_win(60000).with_sack(base + 5 * mss, base + 6 * mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(base));
+            test.execute(ExpectNoSegment{});
+
+            // the next duplicate acks retransmit the other holes right away, not one per RTT
+            test.execute(AckReceived{base}.with_win(60000).with_sack(base + 5 * mss, base + 7 * mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(base + 2 * mss));
+            test.execute(AckReceived{base}.with_win(60000).with_sack(base + 5 * mss, base + 8 * mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(base + 4 * mss));
+            // sacked segments are never retransmitted
+            test.execute(AckReceived{base}.with_win(60000));
+            test.execute(ExpectNoSegment{});
+
+            // partial ack: every hole has already been retransmitted
+            test.execute(AckReceived{base + 2 * mss}.with_win(60000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{base + 8 * mss}.with_win(60000));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
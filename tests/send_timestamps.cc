@@ -0,0 +1,59 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 1000;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 10;
+
+            TCPSenderTestHarness test{"Timestamp echoes give RTT samples for retransmitted data (RFC 7323)", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            // SRTT = 50, RTTVAR = 25, RTO = 150
+            test.execute(Tick{50});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_timestamp_echo(0));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 1));
+            test.execute(Tick{150});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 1));
+
+            // the ack echoes the retransmission sent at 200: SRTT = 47.5, RTTVAR = 23.75, RTO = 143
+            test.execute(Tick{30});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000).with_timestamp_echo(200));
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 4));
+            test.execute(Tick{142});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 4));
+
+            // an echo on an ack of no new data gives no sample
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000).with_timestamp_echo(0));
+            test.execute(Tick{285});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 4));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -15,6 +15,8 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 const unsigned int DEFAULT_TEST_WINDOW = 137;
 
@@ -191,11 +193,19 @@ struct Tick : public SenderAction {
 struct AckReceived : public SenderAction {
     WrappingInt32 _ackno;
     std::optional<uint16_t> _window_advertisement{};
+    std::vector<std::pair<WrappingInt32, WrappingInt32>> _sack{};
+    std::optional<uint32_t> _timestamp_echo{};
 
     AckReceived(WrappingInt32 ackno) : _ackno(ackno) {}
     std::string description() const {
         std::ostringstream ss;
         ss << "ack " << _ackno.raw_value() << " winsize " << _window_advertisement.value_or(DEFAULT_TEST_WINDOW);
+        for (const auto &[left, right] : _sack) {
+            ss << " sack " << left << "-" << right;
+        }
+        if (_timestamp_echo.has_value()) {
+            ss << " tsecr " << _timestamp_echo.value();
+        }
         return ss.str();
     }
 
@@ -204,12 +214,40 @@ struct AckReceived : public SenderAction {
         return *this;
     }
 
+    AckReceived &with_sack(WrappingInt32 left, WrappingInt32 right) {
+        _sack.emplace_back(left, right);
+        return *this;
+    }
+
+    AckReceived &with_timestamp_echo(uint32_t tsecr) {
+        _timestamp_echo.emplace(tsecr);
+        return *this;
+    }
+
     void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (not _sack.empty()) {
+            sender.sack_received(_sack);
+        }
+        if (_timestamp_echo.has_value()) {
+            sender.timestamp_echo_received(_timestamp_echo.value());
+        }
         sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW));
         sender.fill_window();
     }
 };
 
+struct SetCorked : public SenderAction {
+    bool _corked;
+
+    SetCorked(const bool corked) : _corked(corked) {}
+    std::string description() const { return _corked ? "cork" : "uncork"; }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        sender.set_corked(_corked);
+        sender.fill_window();
+    }
+};
+
 struct Close : public SenderAction {
     Close() {}
     std::string description() const { return "close"; }
@@ -394,7 +432,7 @@ class TCPSenderTestHarness {
   public:
     TCPSenderTestHarness(const std::string &name_, TCPConfig config)
         : outbound_segments()
-        , sender(config.send_capacity, config.rt_timeout, config.fixed_isn)
+        , sender(config)
         , steps_executed()
         , name(name_) {
         sender.fill_window();
@@ -392,6 +392,7 @@ struct SendSegment : public TCPAction {
     uint16_t win{0};
     size_t payload_size{0};
     std::string data{};
+    std::optional<uint8_t> window_scale{};
 
     SendSegment() {}
 
@@ -403,6 +404,7 @@ struct SendSegment : public TCPAction {
         seqno = seg.header().seqno;
         ackno = seg.header().ackno;
         win = seg.header().win;
+        window_scale = seg.header().window_scale;
         data = seg.payload();
     }
 
@@ -450,6 +452,11 @@ struct SendSegment : public TCPAction {
         return *this;
     }
 
+    SendSegment &with_window_scale(uint8_t window_scale_) {
+        window_scale = window_scale_;
+        return *this;
+    }
+
     SendSegment &with_data(std::string &&data_) {
         data = data_;
         return *this;
@@ -466,6 +473,7 @@ struct SendSegment : public TCPAction {
         data_hdr.ackno = ackno;
         data_hdr.seqno = seqno;
         data_hdr.win = win;
+        data_hdr.window_scale = window_scale;
         return data_seg;
     }
 
@@ -0,0 +1,113 @@
+#include "test_err_if.hh"
+#include "util/timer_wheel.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        // test 1: timers expire at their deadline, in order, across every level and the overflow
+        {
+            TimerWheel wheel{1000};
+            vector<uint64_t> expired;
+            const vector<uint64_t> deadlines{1000, 1001, 1063, 1064, 5000, 300000, 1000000, 20000000, 1000000000};
+            for (auto it = deadlines.rbegin(); it != deadlines.rend(); ++it) {
+                const uint64_t deadline = *it;
+                wheel.schedule(deadline, [&, deadline] { expired.push_back(deadline); });
+            }
+            for (size_t i = 0; i < deadlines.size(); ++i) {
+                const uint64_t deadline = deadlines[i];
+                test_err_if(wheel.next_deadline() != deadline, "test 1 failed: wrong next deadline");
+                wheel.advance(deadline - 1);
+                test_err_if(expired.size() != i, "test 1 failed: early expiry");
+                wheel.advance(deadline);
+                test_err_if(expired.empty() or expired.back() != deadline,
+                            "test 1 failed: timer " + to_string(deadline) + " did not expire");
+            }
+            test_err_if(wheel.size() != 0 or wheel.next_deadline().has_value(), "test 1 failed: wheel not empty");
+        }
+
+        // test 2: canceled timers do not expire, and a callback can schedule a timer that is already due
+        {
+            TimerWheel wheel{};
+            size_t calls = 0;
+            const auto id = wheel.schedule(10, [&] { calls += 100; });
+            wheel.schedule(10, [&] {
+                calls++;
+                wheel.schedule(5, [&] { calls++; });
+            });
+            test_err_if(not wheel.cancel(id), "test 2 failed: cancel");
+            test_err_if(wheel.cancel(id), "test 2 failed: cancel twice");
+            wheel.advance(10);
+            test_err_if(calls != 2, "test 2 failed: " + to_string(calls) + " calls");
+        }
+
+        // test 3: random schedules, cancels and advances agree with a sorted list of deadlines
+        {
+            struct Entry {
+                uint64_t deadline;
+                TimerWheel::TimerId id;
+            };
+            mt19937 rd{4321};
+            uint64_t now = rd() % 100000;
+            TimerWheel wheel{now};
+            multimap<uint64_t, size_t> model;
+            map<size_t, Entry> entries;
+            vector<pair<size_t, uint64_t>> expired;
+            for (size_t tag = 0; tag < 20000; ++tag) {
+                switch (rd() % 4) {
+                    case 0:
+                    case 1: {
+                        const uint64_t deadline = now + rd() % (uint64_t(1) << (rd() % 30));
+                        const auto id = wheel.schedule(deadline, [&, tag, deadline] {
+                            expired.emplace_back(tag, deadline);
+                        });
+                        model.emplace(deadline, tag);
+                        entries.emplace(tag, Entry{deadline, id});
+                        break;
+                    }
+                    case 2:
+                        if (not model.empty()) {
+                            auto victim = model.begin();
+                            advance(victim, rd() % model.size());
+                            test_err_if(not wheel.cancel(entries.at(victim->second).id), "test 3 failed: cancel");
+                            model.erase(victim);
+                        }
+                        break;
+                    default: {
+                        now += rd() % (uint64_t(1) << (rd() % 26));
+                        expired.clear();
+                        wheel.advance(now);
+                        const auto end = model.upper_bound(now);
+                        test_err_if(expired.size() != size_t(distance(model.begin(), end)),
+                                    "test 3 failed: wrong number of timers expired");
+                        for (size_t i = 0; i < expired.size(); ++i) {
+                            test_err_if(entries.at(expired[i].first).deadline > now, "test 3 failed: early expiry");
+                            test_err_if(i > 0 and expired[i].second < expired[i - 1].second,
+                                        "test 3 failed: expiry out of order");
+                        }
+                        model.erase(model.begin(), end);
+                    }
+                }
+                test_err_if(wheel.size() != model.size(), "test 3 failed: wrong size");
+                const auto next = wheel.next_deadline();
+                test_err_if(next.has_value() != not model.empty(), "test 3 failed: next deadline presence");
+                test_err_if(next.has_value() and next.value() != model.begin()->first,
+                            "test 3 failed: wrong next deadline");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}